@@ -0,0 +1,106 @@
+// Avoid.c
+// Obstacle avoidance after a bump.  The line is only looked
+// for in the last phase: while backing off and turning, the
+// sensors are still over the line the robot left.
+
+#include <stdint.h>
+#include "Avoid.h"
+
+// ------------Avoid_Init------------
+// Set the maneuver and clear the statistics.
+void Avoid_Init(Avoid_t *a, uint16_t brakeMs, uint16_t backMs, uint16_t turnMs,
+                uint16_t arcMs, uint16_t seekMs, int32_t back, int32_t turn,
+                int32_t outer, int32_t inner, int32_t seekInner){
+  a->brakeMs = brakeMs;
+  a->backMs = backMs;
+  a->turnMs = turnMs;
+  a->arcMs = arcMs;
+  a->seekMs = seekMs;
+  a->back = back;
+  a->turn = turn;
+  a->outer = outer;
+  a->inner = inner;
+  a->seekInner = seekInner;
+  a->phase = AVOID_IDLE;
+  a->side = 1;
+  a->detours = 0;
+  a->rejoined = 0;
+  a->missed = 0;
+  a->lastMs = 0;
+}
+
+// number of set bits in a switch group, at most 3
+static int8_t Avoid_Count(uint8_t bits){
+  int8_t n = 0;
+  while(bits){
+    bits &= bits - 1;
+    n++;
+  }
+  return n;
+}
+
+// ------------Avoid_Bump------------
+// Start (or restart) a detour.
+void Avoid_Bump(Avoid_t *a, uint8_t bump, int8_t hint, uint32_t now){
+  int8_t left = Avoid_Count(bump&AVOID_LEFT_BUMPS);
+  int8_t right = Avoid_Count(bump&AVOID_RIGHT_BUMPS);
+  if(left > right){
+    a->side = 1;                        // obstacle on the left, go around the right
+  }else if(right > left){
+    a->side = -1;
+  }else{
+    a->side = (hint < 0) ? -1 : 1;
+  }
+  a->detours++;
+  a->phase = AVOID_BRAKE;
+  a->start = now;
+  a->phaseEnd = now + a->brakeMs;
+}
+
+// ------------Avoid_Step------------
+// Run the detour for one step.
+uint8_t Avoid_Step(Avoid_t *a, uint8_t data, uint32_t now,
+                   int32_t *left, int32_t *right){
+  if(a->phase == AVOID_IDLE){
+    return AVOID_IDLE;
+  }
+  if(a->phase == AVOID_SEEK && data){   // line found, the tracker takes it from here
+    a->rejoined++;
+    a->lastMs = now - a->start;
+    a->phase = AVOID_IDLE;
+    return AVOID_IDLE;
+  }
+  if((int32_t)(now - a->phaseEnd) >= 0){ // phase over, next one
+    switch(a->phase){
+      case AVOID_BRAKE: a->phase = AVOID_BACK; a->phaseEnd = now + a->backMs; break;
+      case AVOID_BACK:  a->phase = AVOID_TURN; a->phaseEnd = now + a->turnMs; break;
+      case AVOID_TURN:  a->phase = AVOID_ARC;  a->phaseEnd = now + a->arcMs;  break;
+      case AVOID_ARC:   a->phase = AVOID_SEEK; a->phaseEnd = now + a->seekMs; break;
+      default:                          // never found the line, line recovery takes over
+        a->missed++;
+        a->phase = AVOID_IDLE;
+        return AVOID_IDLE;
+    }
+  }
+  switch(a->phase){
+    case AVOID_BACK:
+      *left = -a->back;
+      *right = -a->back;
+      break;
+    case AVOID_TURN:                    // pivot toward the detour side
+      *left = a->side*a->turn;
+      *right = -a->side*a->turn;
+      break;
+    case AVOID_ARC:                     // curve back across, around the obstacle
+      *left = (a->side > 0) ? a->inner : a->outer;
+      *right = (a->side > 0) ? a->outer : a->inner;
+      break;
+    case AVOID_SEEK:
+      *left = (a->side > 0) ? a->seekInner : a->outer;
+      *right = (a->side > 0) ? a->outer : a->seekInner;
+      break;
+    default:
+      break;
+  }
+  return a->phase;
+}
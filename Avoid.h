@@ -0,0 +1,78 @@
+// Avoid.h
+// Obstacle avoidance after a bump.  Picks the detour side
+// from which switches were touched, then brakes, backs off,
+// turns away, arcs around the obstacle and sweeps back in
+// until the reflectance array finds the line again.  Each
+// step is a fixed amount of work; no hardware access, so a
+// simulated robot can drive it on the host.
+
+#ifndef AVOID_H_
+#define AVOID_H_
+#include <stdint.h>
+
+// phases
+#define AVOID_IDLE  0           // tracking, not avoiding
+#define AVOID_BRAKE 1           // motors shorted, caller drives nothing
+#define AVOID_BACK  2           // straight back off the obstacle
+#define AVOID_TURN  3           // pivot away from the obstacle
+#define AVOID_ARC   4           // wide arc around it, line ignored
+#define AVOID_SEEK  5           // tighter arc back in, until the line is seen
+
+// bump switches in Bump_Read() bit order
+#define AVOID_LEFT_BUMPS  0xE0  // Bump5..Bump3, P4.7, P4.6, P4.5
+#define AVOID_RIGHT_BUMPS 0x0D  // Bump2..Bump0, P4.3, P4.2, P4.0
+
+struct Avoid {
+  uint16_t brakeMs, backMs, turnMs, arcMs, seekMs; // phase lengths
+  int32_t back;                 // backward duty while backing off
+  int32_t turn;                 // pivot duty
+  int32_t outer, inner;         // arc duties of the outer and inner wheel
+  int32_t seekInner;            // inner wheel duty while seeking, tighter arc
+  uint8_t phase;                // AVOID_ phase
+  int8_t side;                  // +1 detour to the right, -1 to the left
+  uint32_t start;               // ms at the bump
+  uint32_t phaseEnd;            // ms when the current phase ends
+  // statistics
+  uint32_t detours;             // bumps that started a detour
+  uint32_t rejoined;            // detours that found the line again
+  uint32_t missed;              // detours that timed out, recovery takes over
+  uint32_t lastMs;              // bump to line found, last detour
+};
+typedef struct Avoid Avoid_t;
+
+// ------------Avoid_Init------------
+// Set the maneuver and clear the statistics.
+// Input: a                 avoidance behavior
+//        brakeMs ... seekMs phase lengths in ms
+//        back, turn        backward and pivot duty
+//        outer, inner      arc duties
+//        seekInner         inner wheel duty while seeking the line
+// Output: none
+void Avoid_Init(Avoid_t *a, uint16_t brakeMs, uint16_t backMs, uint16_t turnMs,
+                uint16_t arcMs, uint16_t seekMs, int32_t back, int32_t turn,
+                int32_t outer, int32_t inner, int32_t seekInner);
+
+// ------------Avoid_Bump------------
+// Start (or restart) a detour.  Touches on the left send the
+// robot around the right of the obstacle and the other way
+// around; an even split uses the hint.
+// Input: a     avoidance behavior
+//        bump  touched switches, Bump_Read() bit order
+//        hint  +1 or -1, detour side when the touch is centered
+//        now   time in ms
+// Output: none
+void Avoid_Bump(Avoid_t *a, uint8_t bump, int8_t hint, uint32_t now);
+
+// ------------Avoid_Step------------
+// Run the detour for one step.
+// Input: a      avoidance behavior
+//        data   latest 8-bit reflectance reading, 0 no line
+//        now    time in ms
+//        left   signed left duty, set in BACK, TURN, ARC and SEEK
+//        right  signed right duty
+// Output: phase after this step; AVOID_IDLE hands the wheels back
+//         to the line controller, AVOID_BRAKE drives nothing
+uint8_t Avoid_Step(Avoid_t *a, uint8_t data, uint32_t now,
+                   int32_t *left, int32_t *right);
+
+#endif /* AVOID_H_ */
@@ -0,0 +1,66 @@
+// Battery.c
+// Background battery voltage measurement on ADC14.
+// Each conversion is folded into an exponential average,
+// time constant 8 samples, 80 ms at the 10 ms sample rate.
+
+#include <stdint.h>
+#include "msp.h"
+#include "Battery.h"
+#include "Profile.h"
+
+#define BATTERY_SHIFT 3                 // filter weight 1/8
+
+volatile uint32_t BatteryFilter = 0;    // Q3 average of the 14-bit result
+volatile uint8_t BatteryPrimed = 0;     // 1 after the first conversion
+
+// ------------Battery_Init------------
+// Configure A12 and ADC14 for single conversions.
+void Battery_Init(void){
+  P4->SEL0 |= 0x02;                     // P4.1 analog A12
+  P4->SEL1 |= 0x02;
+  ADC14->CTL0 &= ~0x00000002;           // ENC off while configuring
+  ADC14->CTL0 = 0x04200710;             // SMCLK, sample timer, 192 clocks, on
+// bit   mode
+// 26    1    SHP, sample timer
+// 21-19 100  SSEL, SMCLK=12MHz
+// 18-17 00   CONSEQ, single channel
+// 11-8  0111 SHT0, 192 clocks, 16 us for the high-impedance divider
+// 4     1    ON
+  ADC14->CTL1 = 0x00000030;             // 14-bit, results in MEM[0]
+  ADC14->MCTL[0] = BATTERY_CHANNEL;     // AVCC/AVSS reference
+  ADC14->IER0 = 0x00000001;             // interrupt on MEM[0]
+  BatteryPrimed = 0;
+  NVIC->IP[6] = (NVIC->IP[6]&0xFFFFFF00)|0x00000060; // priority 3
+  NVIC->ISER[0] = 0x01000000;           // enable interrupt 24 in NVIC
+}
+
+// ------------Battery_Start------------
+// Start one conversion if the ADC is idle.
+void Battery_Start(void){
+  if((ADC14->CTL0&0x00010000) == 0){    // not BUSY
+    ADC14->CTL0 |= 0x00000003;          // ENC and SC, start conversion
+  }
+}
+
+// end of conversion
+void ADC14_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_BATTERY);
+  uint32_t sample = ADC14->MEM[0];      // read clears IFG0
+  if(BatteryPrimed){
+    BatteryFilter += sample - (BatteryFilter >> BATTERY_SHIFT);
+  }else{
+    BatteryFilter = sample << BATTERY_SHIFT;
+    BatteryPrimed = 1;
+  }
+  PROFILE_EXIT(PROFILE_BATTERY);
+}
+
+// ------------Battery_Millivolts------------
+// Filtered battery voltage.
+uint32_t Battery_Millivolts(void){
+  if(BatteryPrimed == 0){
+    return 0;
+  }
+  // 3300 mV full scale over 2^14 codes, times the divider
+  return ((BatteryFilter >> BATTERY_SHIFT)*3300*BATTERY_DIVIDER) >> 14;
+}
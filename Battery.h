@@ -0,0 +1,40 @@
+// Battery.h
+// Background battery voltage measurement on ADC14.  One
+// conversion per Battery_Start(), read in the ADC14 interrupt
+// and low-pass filtered, so the motor PWM ripple on the pack
+// does not reach the duty compensation.
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+#include <stdint.h>
+
+// battery divider input, change to match the board
+#ifndef BATTERY_CHANNEL
+#define BATTERY_CHANNEL 12          // A12 on P4.1
+#endif
+#ifndef BATTERY_DIVIDER
+#define BATTERY_DIVIDER 3           // VBAT/3 at the pin
+#endif
+
+// ------------Battery_Init------------
+// Configure P4.1 as analog input A12 and ADC14 for single
+// 14-bit conversions against AVCC = 3.3 V, with an interrupt
+// at the end of each conversion.
+// Input: none
+// Output: none
+void Battery_Init(void);
+
+// ------------Battery_Start------------
+// Start one conversion if the ADC is idle.  Call at a fixed
+// rate, e.g. every 10 ms.
+// Input: none
+// Output: none
+void Battery_Start(void);
+
+// ------------Battery_Millivolts------------
+// Filtered battery voltage.
+// Input: none
+// Output: battery voltage in mV, 0 before the first sample
+uint32_t Battery_Millivolts(void);
+
+#endif /* BATTERY_H_ */
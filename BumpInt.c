@@ -48,10 +48,34 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #include <stdint.h>
 #include "msp.h"
-#include "../inc/Motor.h"
+#include "Motor.h"
+#include "BumpInt.h"
+#include "Timebase.h"
+#include "Profile.h"
+
+#define BUMP_QUEUE 16                   // power of 2
 
 void (*collision_handle)(uint8_t);
 
+// single-producer (PORT4 ISR), single-consumer (BumpInt_Poll) ring
+struct BumpEvent {
+  uint32_t time;                        // Timebase_Cycles() at the interrupt
+  uint8_t touched;                      // P4 flags that fired
+};
+struct BumpEvent BumpQueue[BUMP_QUEUE];
+volatile uint8_t BumpPut = 0;           // written only by the ISR
+volatile uint8_t BumpGet = 0;           // written only by BumpInt_Poll
+uint32_t BumpLast[BUMP_SWITCHES];       // time of the last accepted touch
+uint8_t BumpSeen = 0;                   // switches with a valid BumpLast
+uint32_t BumpTouches[BUMP_SWITCHES];
+uint32_t BumpAccepted[BUMP_SWITCHES];
+uint32_t BumpDropped = 0;
+uint32_t BumpLatency = 0;
+uint32_t BumpLatencyMax = 0;
+static uint32_t BumpDebounce;           // BUMP_DEBOUNCE_MS in bus cycles
+
+static const uint8_t BumpPin[BUMP_SWITCHES] = {0x01, 0x04, 0x08, 0x20, 0x40, 0x80};
+
 // Initialize Bump sensors
 // Make six Port 4 pins inputs
 // Activate interface pullup
@@ -60,6 +84,7 @@ void (*collision_handle)(uint8_t);
 void BumpInt_Init(void(*task)(uint8_t)){
     // Store collision handle function
     collision_handle = task;
+    BumpDebounce = Timebase_MsToCycles(BUMP_DEBOUNCE_MS);
 
     // Bump Switches Init //
     P4->SEL0 &= ~0xED;
@@ -91,9 +116,55 @@ uint8_t Bump_Read(void){
 
 
 
-// we do not care about critical section/race conditions
 // triggered on touch, falling edge
+// acknowledge, timestamp and queue; the task runs later from BumpInt_Poll
 void PORT4_IRQHandler(void){
+    PROFILE_ENTER(PROFILE_PORT4);
+    uint32_t time = Timebase_Cycles();
+    uint8_t touched = P4->IFG&0xED;
+    uint8_t put = BumpPut;
+    P4->IFG &= ~touched;    // clear only what was seen, a new edge interrupts again
+
+    if(((put + 1)&(BUMP_QUEUE-1)) == BumpGet){
+        BumpDropped++;      // queue full
+        PROFILE_EXIT(PROFILE_PORT4);
+        return;
+    }
+    BumpQueue[put].time = time;
+    BumpQueue[put].touched = touched;
+    BumpPut = (put + 1)&(BUMP_QUEUE-1); // publish after the event is written
+    PROFILE_EXIT(PROFILE_PORT4);
+}
 
-    collision_handle(Bump_Read());
+// ------------BumpInt_Poll------------
+// Debounce the queued touches and run the collision task.
+uint8_t BumpInt_Poll(void){
+    uint8_t get = BumpGet;
+    uint8_t accepted = 0;
+    uint32_t first = 0;
+    int i;
+
+    while(get != BumpPut){
+        struct BumpEvent *event = &BumpQueue[get];
+        for(i = 0; i < BUMP_SWITCHES; i++){
+            if(event->touched&BumpPin[i]){
+                BumpTouches[i]++;
+                if(!(BumpSeen&(1<<i)) || (event->time - BumpLast[i]) >= BumpDebounce){
+                    if(accepted == 0) first = event->time;
+                    accepted |= BumpPin[i];
+                    BumpAccepted[i]++;
+                    BumpLast[i] = event->time;
+                    BumpSeen |= 1<<i;
+                }
+            }
+        }
+        get = (get + 1)&(BUMP_QUEUE-1);
+        BumpGet = get;      // slot is free for the ISR again
+    }
+    if(accepted){
+        collision_handle(accepted);
+        BumpLatency = Timebase_Elapsed(first);
+        if(BumpLatency > BumpLatencyMax) BumpLatencyMax = BumpLatency;
+    }
+    return accepted;
 }
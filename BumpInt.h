@@ -0,0 +1,45 @@
+// BumpInt.h
+// Bump switches on P4.7, P4.6, P4.5, P4.3, P4.2, P4.0.
+// The port interrupt only clears its flags, timestamps the
+// touch and queues it; BumpInt_Poll() debounces the queue and
+// runs the collision task from the main loop.
+
+#ifndef BUMPINT_H_
+#define BUMPINT_H_
+#include <stdint.h>
+
+#define BUMP_SWITCHES 6
+#define BUMP_DEBOUNCE_MS 20         // later touches of the same switch are bounce
+
+// ------------BumpInt_Init------------
+// Make the six bump pins inputs with pull-ups, interrupting
+// on the falling edge (touch), and start the cycle counter
+// used for timestamps.
+// Input: task  collision task, called from BumpInt_Poll()
+//              with the touched switches in Bump_Read() bit order
+// Output: none
+void BumpInt_Init(void(*task)(uint8_t));
+
+// ------------Bump_Read------------
+// Read current state of 6 switches.
+// Input: none
+// Output: positive logic P4 bits, 1 means pressed
+uint8_t Bump_Read(void);
+
+// ------------BumpInt_Poll------------
+// Empty the touch queue: drop touches within BUMP_DEBOUNCE_MS
+// of the last accepted one on the same switch, then call the
+// collision task once with all accepted switches.  Call from
+// the main loop.
+// Input: none
+// Output: switches passed to the task, 0 if it was not called
+uint8_t BumpInt_Poll(void);
+
+// statistics, index 0 is Bump0 (P4.0) through 5 is Bump5 (P4.7)
+extern uint32_t BumpTouches[BUMP_SWITCHES];  // edges queued
+extern uint32_t BumpAccepted[BUMP_SWITCHES]; // edges passed to the task
+extern uint32_t BumpDropped;                 // edges lost to a full queue
+extern uint32_t BumpLatency;                 // edge to task call, last, cycles
+extern uint32_t BumpLatencyMax;              // edge to task call, worst, cycles
+
+#endif /* BUMPINT_H_ */
@@ -0,0 +1,130 @@
+// Calibration.c
+// Runs on MSP432
+// Automatic calibration of the QTRX reflectance array.  The
+// robot spins over the line while decay-time frames are
+// taken, then per-channel white/black decay times and the
+// sample windows are saved to INFO flash.
+
+#include <stdint.h>
+#include "msp.h"
+#include "Motor.h"
+#include "CortexM.h"
+#include "Reflectance.h"
+#include "InfoFlash.h"
+#include "Calibration.h"
+
+#define CAL_FRAMES   400        // about 2 s of spinning
+#define CAL_STEP     25         // decay sample interval, usec, about 6% of the CPU while sampling
+#define CAL_TIMEOUT  5000       // longest decay measured, usec
+#define CAL_MARGIN   250        // added to the slowest decay for the timeout
+
+// window 980 us is the value tuned by hand before calibration existed
+CalProfile_t CalProfile = {
+  0,
+  {0, 0, 0, 0, 0, 0, 0, 0},
+  {CAL_TIMEOUT, CAL_TIMEOUT, CAL_TIMEOUT, CAL_TIMEOUT,
+   CAL_TIMEOUT, CAL_TIMEOUT, CAL_TIMEOUT, CAL_TIMEOUT},
+  {980, 980, 980, 980, 980, 980, 980, 980},
+  980,
+  CAL_TIMEOUT,
+  CAL_STEP,
+  0,
+  0
+};
+
+// sum of every word before the checksum
+static uint32_t Calibration_Sum(const CalProfile_t *p){
+  const uint32_t *word = (const uint32_t *)p;
+  uint32_t sum = 0;
+  uint32_t i;
+  for(i=0; i<(sizeof(CalProfile_t)/4)-1; i++){
+    sum += word[i];
+  }
+  return sum;
+}
+
+// ------------Calibration_Load------------
+// Copy the stored profile from INFO flash if it is valid.
+// Input: none
+// Output: 0 if loaded, 1 if no valid profile is stored
+//         (CalProfile keeps the defaults)
+uint8_t Calibration_Load(void){
+  const CalProfile_t *stored = (const CalProfile_t *)INFOFLASH_RECORD;
+  if((stored->key != CAL_KEY) || (stored->checksum != Calibration_Sum(stored))){
+    return 1;
+  }
+  CalProfile = *stored;
+  return 0;
+}
+
+// ------------Calibration_Run------------
+// Spin the robot in place over the line, measure every
+// channel, and save the profile to INFO flash.
+// Input: none
+// Output: 0 on success, 1 if a channel saw no contrast
+//         (profile not changed), 2 if the flash write failed
+uint8_t Calibration_Run(void){
+  CalProfile_t p;
+  uint16_t time[8];
+  uint16_t whiteMax = 0;            // slowest white channel
+  uint16_t blackMin = CAL_TIMEOUT;  // fastest black channel
+  uint32_t frame;
+  int i;
+
+  for(i=0; i<8; i++){
+    p.white[i] = CAL_TIMEOUT;
+    p.black[i] = 0;
+  }
+  Motor_Right(2667, 2667);          // spin in place so every sensor crosses the line
+  for(frame=0; frame<CAL_FRAMES; frame++){
+    while(Reflectance_StartDecay(CAL_STEP, CAL_TIMEOUT)){
+      WaitForInterrupt();           // a control frame is still in flight
+    }
+    while(Reflectance_GetDecay(time) == 0){
+      WaitForInterrupt();           // Timer A2 finishes the frame
+    }
+    for(i=0; i<8; i++){
+      if(time[i] < p.white[i]) p.white[i] = time[i];
+      if(time[i] > p.black[i]) p.black[i] = time[i];
+    }
+  }
+  Motor_Stop();
+
+  for(i=0; i<8; i++){
+    if(p.black[i] - p.white[i] < REFLECTANCE_CONTRAST){
+      return 1;                     // channel never saw the line
+    }
+    p.threshold[i] = (p.white[i] + p.black[i])/2;
+    if(p.white[i] > whiteMax) whiteMax = p.white[i];
+    if(p.black[i] < blackMin) blackMin = p.black[i];
+  }
+  // one window for all channels: centered between the slowest
+  // white and the fastest black when they separate, else the
+  // average of the per-channel midpoints
+  if(blackMin > whiteMax){
+    p.window = (whiteMax + blackMin)/2;
+  }else{
+    uint32_t sum = 0;
+    for(i=0; i<8; i++){
+      sum += p.threshold[i];
+    }
+    p.window = sum/8;
+  }
+  p.timeout = 0;
+  for(i=0; i<8; i++){
+    if(p.black[i] > p.timeout) p.timeout = p.black[i];
+  }
+  p.timeout += CAL_MARGIN;
+  if(p.timeout > CAL_TIMEOUT) p.timeout = CAL_TIMEOUT;
+  p.step = CAL_STEP;                // thresholds are only as fine as the step they were measured at
+  p.spare = 0;
+  p.key = CAL_KEY;
+  p.checksum = Calibration_Sum(&p);
+  CalProfile = p;
+
+  if(InfoFlash_Erase() ||
+     InfoFlash_Write(INFOFLASH_RECORD, (const uint32_t *)&p, sizeof(CalProfile_t)/4)){
+    return 2;                       // in use for this run, but not saved
+  }
+  return 0;
+}
@@ -0,0 +1,48 @@
+// Calibration.h
+// Runs on MSP432
+// Automatic calibration of the QTRX reflectance array.  The
+// robot spins over the line while decay-time frames are
+// taken, then per-channel white/black decay times and the
+// sample windows are saved to INFO flash.
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+#include <stdint.h>
+
+struct CalProfile {
+  uint32_t key;                 // CAL_KEY when the record is valid
+  uint16_t white[8];            // fastest decay seen per channel, usec
+  uint16_t black[8];            // slowest decay seen per channel, usec
+  uint16_t threshold[8];        // midpoint per channel, usec
+  uint16_t window;              // binary capture window, usec
+  uint16_t timeout;             // decay-time capture timeout, usec
+  uint16_t step;                // decay-time sample interval, usec
+  uint16_t spare;               // 0, keeps the checksum word aligned
+  uint32_t checksum;            // sum of the words above
+};
+typedef struct CalProfile CalProfile_t;
+
+#define CAL_KEY 0x43414C32      // "CAL2", CAL1 records had no step
+
+// profile in use, defaults until loaded or calibrated
+extern CalProfile_t CalProfile;
+
+// ------------Calibration_Load------------
+// Copy the stored profile from INFO flash if it is valid.
+// Input: none
+// Output: 0 if loaded, 1 if no valid profile is stored
+//         (CalProfile keeps the defaults)
+uint8_t Calibration_Load(void);
+
+// ------------Calibration_Run------------
+// Spin the robot in place over the line, measure every
+// channel, and save the profile to INFO flash.  Blocks for
+// about two seconds; run from main with the control loop
+// stopped and interrupts enabled.
+// Input: none
+// Output: 0 on success, 1 if a channel saw no contrast
+//         (profile not changed), 2 if the flash write failed
+// Assumes: Motor_Init() and Reflectance_Init() have been called
+uint8_t Calibration_Run(void);
+
+#endif /* CALIBRATION_H_ */
@@ -39,6 +39,8 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #include <stdint.h>
 #include "msp.h"
+#include "Clock.h"
+#include "Timebase.h"
 
 uint32_t ClockFrequency = 3000000; // cycles/second
 //static uint32_t SubsystemFrequency = 3000000; // cycles/second
@@ -57,6 +59,7 @@ uint32_t Postwait = 0;                  // loops between Current Power Mode matc
 uint32_t IFlags = 0;                    // non-zero if transition is invalid
 uint32_t Crystalstable = 0;             // loops before the crystal stabilizes (expect small)
 void Clock_Init48MHz(void){
+  Timebase_Init();                      // delays work at the 3 MHz DCO even if a time out below returns early
   // wait for the PCMCTL0 and Clock System to be write-able by waiting for Power Control Manager to be idle
   while(PCM->CTL1&0x00000100){
 //  while(PCMCTL1&0x00000100){
@@ -123,6 +126,7 @@ void Clock_Init48MHz(void){
   CS->KEY = 0;                          // lock CS module from unintended access
   ClockFrequency = 48000000;
 //  SubsystemFrequency = 12000000;
+  Timebase_Init();                      // delays and timestamps follow the new 48 MHz clock
 }
 
 // ------------Clock_GetFreq------------
@@ -145,23 +149,17 @@ void delay(unsigned long ulCount){
 }
 
 // ------------Clock_Delay1us------------
-// Simple delay function which delays about n microseconds.
+// Delay n microseconds, counted on the DWT cycle counter.
 // Inputs: n, number of us to wait
 // Outputs: none
 void Clock_Delay1us(uint32_t n){
-  n = (382*n)/100;; // 1 us, tuned at 48 MHz
-  while(n){
-    n--;
-  }
+  Timebase_DelayUs(n);
 }
 
 // ------------Clock_Delay1ms------------
-// Simple delay function which delays about n milliseconds.
+// Delay n milliseconds, counted on the DWT cycle counter.
 // Inputs: n, number of msec to wait
 // Outputs: none
 void Clock_Delay1ms(uint32_t n){
-  while(n){
-    delay(ClockFrequency/9162);   // 1 msec, tuned at 48 MHz
-    n--;
-  }
+  Timebase_DelayMs(n);
 }
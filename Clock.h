@@ -0,0 +1,40 @@
+// Clock.h
+// Runs on the MSP432
+// 48 MHz system clock from the crystal, and busy-wait delays
+// counted on the DWT cycle counter (see Timebase.h), so they
+// hold at any clock rate.
+// Daniel and Jonathan Valvano
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+#include <stdint.h>
+
+// ------------Clock_Init48MHz------------
+// Configure for MCLK = HFXTCLK = 48 MHz, HSMCLK = 24 MHz and
+// SMCLK = 12 MHz, and restart the timebase at the new rate.
+// Input: none
+// Output: none
+void Clock_Init48MHz(void);
+
+// ------------Clock_GetFreq------------
+// Return the current system clock frequency.
+// Input: none
+// Output: system clock frequency in cycles/second
+uint32_t Clock_GetFreq(void);
+
+// ------------Clock_Delay1us------------
+// Simple delay function which delays about n microseconds.
+// Input: n, number of us to wait
+// Output: none
+void Clock_Delay1us(uint32_t n);
+
+// ------------Clock_Delay1ms------------
+// Simple delay function which delays about n milliseconds.
+// Input: n, number of msec to wait
+// Output: none
+void Clock_Delay1ms(uint32_t n);
+
+// delay function from the RSLK labs, about 6*ulCount cycles
+void delay(unsigned long ulCount);
+
+#endif /* CLOCK_H_ */
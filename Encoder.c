@@ -0,0 +1,123 @@
+// Encoder.c
+// Wheel encoders on Timer A3 input capture.
+// Speed is one over the period between the two newest rising
+// edges of encoder A; encoder B, read in the capture interrupt,
+// gives the direction.
+
+#include <stdint.h>
+#include "msp.h"
+#include "Encoder.h"
+#include "Profile.h"
+
+#define ENCODER_CLOCK    1500000                // Timer A3 counts per second
+#define ENCODER_SPEED_K  ((ENCODER_CLOCK/1000)*ENCODER_UM_PER_TICK) // mm/s times period
+#define ENCODER_STALL_MS 40                     // under the 43.7 ms timer wrap
+
+volatile int32_t EncoderTicks[2];       // signed edge count
+volatile uint16_t EncoderLast[2];       // capture time of the newest edge
+volatile uint16_t EncoderPeriod[2];     // counts between the two newest edges, 0 unknown
+volatile uint8_t EncoderStalled[2];     // 1 after ENCODER_STALL_MS without an edge
+int32_t EncoderSpeed[2];                // mm/s, set by Encoder_Step()
+int32_t EncoderSeen[2];                 // EncoderTicks at the last edge Encoder_Step() saw
+uint32_t EncoderIdle[2];                // ms since Encoder_Step() saw an edge
+
+// ------------Encoder_Init------------
+// Configure Timer A3 capture on the rising edge of encoder A.
+void Encoder_Init(void){
+  int i;
+  P10->SEL0 |= 0x30;                    // P10.4, P10.5 TA3CCP0, TA3CCP1
+  P10->SEL1 &= ~0x30;
+  P10->DIR &= ~0x30;                    // inputs
+  P5->SEL0 &= ~0x05;                    // P5.0, P5.2 GPIO
+  P5->SEL1 &= ~0x05;
+  P5->DIR &= ~0x05;                     // inputs
+  for(i=0; i<2; i++){
+    EncoderTicks[i] = 0;
+    EncoderPeriod[i] = 0;
+    EncoderStalled[i] = 1;              // first period after a stop is not valid
+    EncoderSpeed[i] = 0;
+    EncoderSeen[i] = 0;
+    EncoderIdle[i] = 0;
+  }
+  TIMER_A3->CTL = 0x02C4;               // SMCLK, divide by 8, stop, clear
+  TIMER_A3->EX0 = 0x0000;               //    divide by 1
+  TIMER_A3->CCTL[0] = 0x4910;           // capture rising edge, CCI0A, sync, CCIE
+  TIMER_A3->CCTL[1] = 0x4910;           // capture rising edge, CCI1A, sync, CCIE
+// bit  mode
+// 15-14 01   CM, capture on rising edge
+// 13-12 00   CCIS, CCIxA
+// 11    1    SCS, synchronous capture
+// 8     1    CAP, capture mode
+// 4     1    CCIE, interrupt
+  NVIC->IP[3] = (NVIC->IP[3]&0x0000FFFF)|0x20200000; // priority 1, interrupts 14 and 15
+  NVIC->ISER[0] = 0x0000C000;           // enable interrupts 14 and 15 in NVIC
+  TIMER_A3->CTL = 0x02E4;               // SMCLK/8, continuous mode, clear
+}
+
+// one rising edge of encoder A, forward is the wheel's own sense of B
+static void Encoder_Edge(uint8_t wheel, uint16_t time, uint8_t forward){
+  if(EncoderStalled[wheel]){
+    EncoderStalled[wheel] = 0;          // timer may have wrapped since the last edge
+    EncoderPeriod[wheel] = 0;
+  }else{
+    EncoderPeriod[wheel] = time - EncoderLast[wheel]; // modulo 2^16
+  }
+  EncoderLast[wheel] = time;
+  EncoderTicks[wheel] += forward ? 1 : -1;
+}
+
+// right encoder A on TA3CCP0
+// The motors face each other, so the same robot motion turns
+// the two encoders opposite ways: right is forward with B low.
+void TA3_0_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_ENCODER);
+  TIMER_A3->CCTL[0] &= ~0x0001;         // acknowledge CCIFG
+  Encoder_Edge(ENCODER_RIGHT, TIMER_A3->CCR[0], (P5->IN&0x01) == 0);
+  PROFILE_EXIT(PROFILE_ENCODER);
+}
+
+// left encoder A on TA3CCP1, forward with B high
+void TA3_N_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_ENCODER);
+  TIMER_A3->CCTL[1] &= ~0x0001;         // acknowledge CCIFG
+  Encoder_Edge(ENCODER_LEFT, TIMER_A3->CCR[1], P5->IN&0x04);
+  PROFILE_EXIT(PROFILE_ENCODER);
+}
+
+// ------------Encoder_Step------------
+// Update the wheel speeds from the newest edge periods.
+void Encoder_Step(uint32_t ms){
+  int i;
+  int32_t ticks;
+  uint16_t period;
+  for(i=0; i<2; i++){
+    ticks = EncoderTicks[i];
+    period = EncoderPeriod[i];
+    if(ticks != EncoderSeen[i]){
+      if(period){                       // direction of the newest edge
+        EncoderSpeed[i] = (ticks > EncoderSeen[i]) ? ENCODER_SPEED_K/period
+                                                   : -(ENCODER_SPEED_K/period);
+      }
+      EncoderSeen[i] = ticks;
+      EncoderIdle[i] = 0;
+    }else{
+      EncoderIdle[i] += ms;
+      if(EncoderIdle[i] >= ENCODER_STALL_MS){
+        EncoderStalled[i] = 1;          // slower than the timer can measure
+        EncoderSpeed[i] = 0;
+      }
+    }
+  }
+}
+
+// ------------Encoder_Speed------------
+// Signed wheel speed from the last Encoder_Step().
+int32_t Encoder_Speed(uint8_t wheel){
+  return EncoderSpeed[wheel];
+}
+
+// ------------Encoder_Ticks------------
+// Signed edge count since Encoder_Init().
+int32_t Encoder_Ticks(uint8_t wheel){
+  return EncoderTicks[wheel];
+}
@@ -0,0 +1,47 @@
+// Encoder.h
+// Wheel encoders on Timer A3 input capture.
+// Right encoder A: P10.4 (TA3CCP0), B: P5.0, forward when B is low
+// Left encoder A:  P10.5 (TA3CCP1), B: P5.2, forward when B is high
+// The capture interrupts only count the edge and keep its
+// timestamp; Encoder_Step() turns them into speeds at a fixed
+// rate, so interrupt cost per edge is constant.
+
+#ifndef ENCODER_H_
+#define ENCODER_H_
+#include <stdint.h>
+
+#define ENCODER_TICKS_PER_REV 360   // rising edges of A per wheel turn
+#define ENCODER_UM_PER_TICK   611   // 70 mm wheel, pi*70000/360 um
+
+#define ENCODER_RIGHT 0
+#define ENCODER_LEFT  1
+
+// ------------Encoder_Init------------
+// Configure P10.4, P10.5 as Timer A3 capture inputs on the
+// rising edge of encoder A, and P5.0, P5.2 as GPIO inputs for
+// encoder B.  Timer A3 runs continuously at SMCLK/8 = 1.5 MHz.
+// Input: none
+// Output: none
+void Encoder_Init(void);
+
+// ------------Encoder_Step------------
+// Update the wheel speeds from the newest edge periods.  Call
+// at a fixed rate.  A wheel with no edge for ENCODER_STALL_MS
+// reads as stopped.
+// Input: ms  time since the previous call
+// Output: none
+void Encoder_Step(uint32_t ms);
+
+// ------------Encoder_Speed------------
+// Signed wheel speed from the last Encoder_Step().
+// Input: wheel  ENCODER_RIGHT or ENCODER_LEFT
+// Output: speed in mm/s, negative is backward
+int32_t Encoder_Speed(uint8_t wheel);
+
+// ------------Encoder_Ticks------------
+// Signed edge count since Encoder_Init(), forward is positive.
+// Input: wheel  ENCODER_RIGHT or ENCODER_LEFT
+// Output: ticks of ENCODER_UM_PER_TICK each
+int32_t Encoder_Ticks(uint8_t wheel);
+
+#endif /* ENCODER_H_ */
@@ -2,52 +2,208 @@
 #include "Reflectance.h"
 #include "Clock.h"
 #include "Motor.h"
+#include "PWM.h"
 #include "LaunchPad.h"
 #include "SysTickInts.h"
 #include "CortexM.h"
 #include "BumpInt.h"
+#include "Calibration.h"
+#include "PID.h"
+#include "LineFSM.h"
+#include "SpeedPlanner.h"
+#include "LapMap.h"
+#include "Recovery.h"
+#include "Encoder.h"
+#include "WheelSpeed.h"
+#include "Battery.h"
+#include "Avoid.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Timebase.h"
+#include "TimerService.h"
+#include "Profile.h"
 
-void motorState(uint8_t state);
 void SysTick_Handler(void);
 void collision(uint8_t);
+void calibrate(void);
+uint8_t readLine(uint8_t *frame);
+void pidControl(int32_t position);
+void setWheels(int32_t left, int32_t right);
+uint32_t travelled(void);
+void brakeWheels(void);
+void avoidControl(void);
+void stopBench(void);
+void wheelTask(void);
+void wheelsOn(void);
+void wheelsOff(void);
+void background(void);
+void senseTask(void);
+void controlTask(void);
+void powerTask(void);
+void telemetryTask(void);
+
+//LINE CONTROLLER, CHOOSE AT COMPILE TIME WITH -DCONTROL_DEFAULT=CONTROL_PID
+//OR CHANGE ControlMode AT RUNTIME
+#define CONTROL_FSM 0
+#define CONTROL_PID 1
+#ifndef CONTROL_DEFAULT
+#define CONTROL_DEFAULT CONTROL_FSM
+#endif
+
+//PID TUNING, Q16 GAINS ON LINE POSITION IN MICRONS
+#define PID_KP     13107        //0.2 duty per micron
+#define PID_KI     88           //0.00133 duty per micron per frame
+#define PID_KD     43691        //0.667 duty per micron of change per frame
+#define PID_ALPHA  49152        //0.75 derivative filter
+#define PID_OUTMAX 5333         //largest differential duty
+#define PID_IMAX   2000         //integral term limit
+#define DUTY_MAX   (PWM_SCALE-1) //DUTIES ARE NORMALIZED, PWM_SCALE IS 100%
+
+//SPEED PLANNER, BASE DUTY OF THE CENTER STATE AND OF THE PID
+#define PLAN_MIN      3333      //base duty in the tightest curve
+#define PLAN_MAX      7333      //base duty on a long straight
+#define PLAN_ACCEL    67        //duty per frame, 0.6 s from min to max
+#define PLAN_DECEL    533       //duty per frame, brake hard into curves
+#define PLAN_CURVE    20000     //microns of error that call for PLAN_MIN
+#define PLAN_STRAIGHT 30        //steady frames before PLAN_MAX, 0.3 s
+
+//WHEEL SPEED LOOP, CONTROLLER DUTIES BECOME SPEED COMMANDS; -DSPEED_LOOP=0 FOR OPEN LOOP
+#ifndef SPEED_LOOP
+#define SPEED_LOOP    1
+#endif
+#define WHEEL_FULL    550       //mm/s at full duty, no load
+#define WHEEL_KFF     1191563   //Q16 duty per mm/s, PWM_SCALE/WHEEL_FULL
+#define WHEEL_KP      524288    //8 duty per mm/s of error
+#define WHEEL_KI      13107     //0.2 duty per mm/s per ms
+#define WHEEL_IMAX    2500      //integral term limit
+#define WHEEL_OUTMAX  3000      //largest PI correction on top of the feed-forward
+
+//OBSTACLE DETOUR AFTER A BUMP, AROUND THE SIDE THAT WAS NOT TOUCHED AND BACK ONTO THE LINE
+#define AVOID_BRAKE_MS  150     //SHORTED MOTORS STOP THE ROBOT
+#define AVOID_BACK_MS   400     //THEN BACK AWAY THIS LONG
+#define AVOID_TURN_MS   350     //PIVOT ABOUT 60 DEGREES AWAY FROM THE OBSTACLE
+#define AVOID_ARC_MS    1600    //ARC AROUND IT, ABOUT 60 DEGREES BACK, LINE IGNORED
+#define AVOID_SEEK_MS   2000    //TIGHTER ARC UNTIL THE LINE IS SEEN, THEN RECOVERY TAKES OVER
+#define AVOID_BACK_DUTY 3000    //BACKWARD DUTY OF BOTH WHEELS
+#define AVOID_TURN_DUTY 4000    //PIVOT DUTY
+#define AVOID_OUTER     4000    //OUTER WHEEL DUTY OF BOTH ARCS
+#define AVOID_INNER     2400    //INNER WHEEL, 28 cm RADIUS
+#define AVOID_SEEK_INNER 1000   //INNER WHEEL WHILE SEEKING, 12 cm RADIUS
+
+//STOPPING BENCHMARK, BOTH BUTTONS HELD AT BOOT
+#define BENCH_SPEED   300       //mm/s BEFORE EACH STOP
+#define BENCH_RUNS    3         //STOPS PER MODE
+#define BENCH_BRAKE   0
+#define BENCH_COAST   1
+
+//LINE RECOVERY, USED BY BOTH CONTROLLERS WHEN NO SENSOR SEES THE LINE
+#define REC_BASE      2667      //forward duty while steering back
+#define REC_TURN      4000      //largest differential duty, pivot duty of the sweep
+#define REC_FULL      20000     //predicted microns off center for full turn
+#define REC_EXTRAP_MS 300       //steer toward the predicted line this long
+#define REC_STRATEGY  REC_SWEEP //then REC_SWEEP or REC_SPIRAL
+#define REC_LEG_MS    250       //first sweep leg, each leg 250 ms longer
+#define REC_LEGS      6         //sweep legs, 5.25 s in all
+#define REC_SPIRAL_MS 4000      //spiral time limit
+
+//TICK SCHEDULER, ONE TICK IS 1 ms; TASKS DUE ON THE SAME TICK RUN IN PRIORITY ORDER, 0 FIRST
+//WITH TICKLESS IDLE ONE SysTick PERIOD IS Scheduler_Stride() TICKS, 10 ms FOR THIS TABLE; -DTICKLESS=0 FOR A 1 ms INTERRUPT
+//EVERY PERIOD AND PHASE IS A MULTIPLE OF 10 ms, A 1 ms PHASE WOULD BRING BACK THE 1 ms INTERRUPT
+//LINE CONTROL RUNS FROM THE MAIN LOOP WHEN TIMER A2 FINISHES A FRAME, THE WHEEL LOOPS ON TIMER A1
+#ifndef TICKLESS
+#define TICKLESS      1
+#endif
+#define TICK_CYCLES   Timebase_MsToCycles(1) //SysTick TICK, 1 ms AT THE BUS CLOCK
+#define WHEEL_MS      1         //WHEEL LOOP PERIOD
+#define TASK_TABLE(TASK) \
+/*     task           period  phase  priority  budget us */ \
+  TASK(senseTask,     10,      0,     0,        20)  /*START A REFLECTANCE CAPTURE*/ \
+  TASK(powerTask,     10,      0,     1,        20)  /*BATTERY SAMPLE AND DUTY SCALE*/ \
+  TASK(telemetryTask, 50,      0,     2,        20)  /*SNAPSHOT FOR THE DEBUGGER*/
+#define TASK_ROW(task, period, phase, priority, budget) {task, period, phase, priority, budget},
+#define TASK_LIMITS(task, period, phase, priority, budget) \
+    FSM_CHECK(bad_period_##task, (period) >= 1 && (phase) < (period));
+#define TASK_ONE(task, period, phase, priority, budget) +1
+
+//COMPILE THE DECLARATIVE STATE MACHINE IN LineFSM.h INTO A FLAT ROM TABLE
+#define FSM_ENUM(X, name, l, r, n0, n1, n2, n3, n4, n5, n6) ST_##name,
+#define FSM_ROW(X, name, l, r, n0, n1, n2, n3, n4, n5, n6) \
+    {l, r, {ST_##n0, ST_##n1, ST_##n2, ST_##n3, ST_##n4, ST_##n5, ST_##n6}},
+#define FSM_SUCC(X, name, l, r, n0, n1, n2, n3, n4, n5, n6) \
+    SUCC_##name = (1<<ST_##n0)|(1<<ST_##n1)|(1<<ST_##n2)|(1<<ST_##n3)|(1<<ST_##n4)|(1<<ST_##n5)|(1<<ST_##n6),
+#define FSM_REACH(R, name, l, r, n0, n1, n2, n3, n4, n5, n6) \
+    | ((((R)>>ST_##name)&1) ? SUCC_##name : 0)
+#define FSM_NEXT(R) ((R) LINE_FSM(FSM_REACH, R))  //STATES REACHABLE IN ONE MORE STEP
+#define FSM_CHECK(name, cond) typedef char name[(cond) ? 1 : -1]
+#define FSM_INDEX(name) FSM_PASTE(name)
+#define FSM_PASTE(name) ST_##name
+#define FSM_LIMITS(X, name, l, r, n0, n1, n2, n3, n4, n5, n6) \
+    FSM_CHECK(duty_out_of_range_##name, (l) > -PWM_SCALE && (l) < PWM_SCALE && (r) > -PWM_SCALE && (r) < PWM_SCALE);
+
+enum { LINE_FSM(FSM_ENUM, 0) FSM_COUNT };
+enum { FSM_START = FSM_INDEX(LINE_FSM_START) };
+enum { LINE_FSM(FSM_SUCC, 0) };
+enum {
+    FSM_REACH0 = 1<<FSM_START,
+    FSM_REACH1 = FSM_NEXT(FSM_REACH0),   FSM_REACH2 = FSM_NEXT(FSM_REACH1),
+    FSM_REACH3 = FSM_NEXT(FSM_REACH2),   FSM_REACH4 = FSM_NEXT(FSM_REACH3),
+    FSM_REACH5 = FSM_NEXT(FSM_REACH4),   FSM_REACH6 = FSM_NEXT(FSM_REACH5),
+    FSM_REACH7 = FSM_NEXT(FSM_REACH6),   FSM_REACH8 = FSM_NEXT(FSM_REACH7),
+    FSM_REACH9 = FSM_NEXT(FSM_REACH8),   FSM_REACH10 = FSM_NEXT(FSM_REACH9),
+    FSM_REACH11 = FSM_NEXT(FSM_REACH10), FSM_REACH12 = FSM_NEXT(FSM_REACH11),
+    FSM_REACH13 = FSM_NEXT(FSM_REACH12), FSM_REACH14 = FSM_NEXT(FSM_REACH13),
+    FSM_REACH15 = FSM_NEXT(FSM_REACH14)  //CLOSURE AFTER AT MOST 15 STEPS
+};
+FSM_CHECK(too_many_states, FSM_COUNT <= 16);
+FSM_CHECK(unreachable_state, FSM_REACH15 == (1<<FSM_COUNT) - 1);
+LINE_FSM(FSM_LIMITS, 0)
 
 struct State {
-  uint8_t out;                  //2-bit output
-  uint8_t debugRGB;             //3-bit output to Launchpad RGB
-  uint8_t debugLED;             //1-bit
-  const struct State *next[6];  // Next if 2-bit input is 0-3
+  int16_t left;                 //signed duty of the left wheel
+  int16_t right;                //signed duty of the right wheel
+  uint8_t next[LINE_FSM_INPUTS]; //next state for each input class
 };
 typedef const struct State State_t;
 
-#define Center    &fsm[0]
-#define Left      &fsm[1]
-#define Right     &fsm[2]
-#define LookF     &fsm[3]
-#define LookB     &fsm[4]
-#define LookR     &fsm[5]
-#define LookL     &fsm[6]
-#define Lost      &fsm[7]
-#define FastL     &fsm[8]
-#define FastR     &fsm[9]
-
-State_t fsm[10]={ //ORDER OF STATES
-
-    {0x1, {Center, Left, Right, LookF, FastL, FastR }}, //same order as states defined above^^^^^
-    {0x2, {Center, Left, Right, LookF, FastL, FastR  }},
-    {0x3, {Center, Left, Right, LookF, FastL, FastR }},
-    {0x4, {Center, Left, Right, LookB, FastL, FastR }},
-    {0x5, {Center, Left, Right, LookL, FastL, FastR }},
-    {0x6, {Center, Left, Right, LookR, FastL, FastR }},
-    {0x7, {Center, Left, Right, LookL,  FastL, FastR }},
-    {0x8, {Lost,   Lost, Lost,  Lost,  Lost, Lost }},
-    {0x9, {Center, Left, Right, LookF, FastL, FastR }},
-    {0xA, {Center, Left, Right, LookF, FastL, FastR  }}
+State_t fsm[FSM_COUNT] = { LINE_FSM(FSM_ROW, 0) };
+
+Task_t Tasks[] = { TASK_TABLE(TASK_ROW) };
+FSM_CHECK(too_many_tasks, (0 TASK_TABLE(TASK_ONE)) <= SCHED_MAX_TASKS);
+TASK_TABLE(TASK_LIMITS)
+
+struct Telemetry {
+  uint32_t ms;                  //Ticks AT THE SNAPSHOT
+  int32_t linePos;              //LINE POSITION IN MICRONS
+  int32_t base;                 //PLANNER DUTY
+  int32_t speed[2];             //WHEEL SPEEDS IN mm/s, ENCODER_RIGHT AND ENCODER_LEFT
+  uint32_t millivolts;          //BATTERY
+  uint8_t state;                //FSM STATE
+  uint8_t detour;               //AVOID PHASE
 };
+typedef struct Telemetry Telemetry_t;
 
-State_t *StatePtr;  //pointer to the current state
+uint8_t State;      //index of the current state
 uint8_t Input;
 volatile uint8_t data;
-uint8_t count = 0;
+uint8_t AmbientRun = REFLECTANCE_AMBIENT_OFF; //AMBIENT LIGHT REJECTION FOR THIS RUN
+uint8_t ControlMode = CONTROL_DEFAULT; //FSM OR PID LINE CONTROLLER
+uint8_t ActiveMode = CONTROL_DEFAULT;  //CONTROLLER RUNNING NOW
+uint8_t CalResult = 0;   //LAST Calibration_Run(): 0 SAVED, 1 NO CONTRAST, 2 FLASH WRITE FAILED
+PID_t LinePID;
+int32_t LinePos;            //LINE POSITION OF THE LAST FRAME IN MICRONS
+int32_t Correction = 0;     //LAST PID OUTPUT
+Planner_t Planner;
+int32_t Base;               //FORWARD DUTY FROM THE SPEED PLANNER
+int32_t LapTicks = 0;       //ENCODER TICKS AT THE LAST LAP MAP UPDATE
+Recovery_t Rescue;          //LINE RECOVERY ENGINE, STATISTICS IN Rescue.found/lastMs/maxMs
+volatile uint32_t Ticks = 0; //MILLISECONDS SINCE SYSTICK STARTED, ADVANCES TickSpan AT A TIME
+uint16_t TickSpan = 1;      //TICKS PER SysTick INTERRUPT
+uint8_t WheelTimer = TIMER_NONE; //WHEEL LOOP EVENT ON TIMER A1, TIMER_NONE WHILE THE ROBOT STANDS STILL
+Avoid_t Detour;             //OBSTACLE DETOUR, STATISTICS IN Detour.detours/rejoined/missed
+uint32_t StopBenchMs[2][BENCH_RUNS]; //BRAKE AND COAST STOPPING TIMES
+uint32_t StopBenchUm[2][BENCH_RUNS]; //AND DISTANCES IN MICRONS
+Telemetry_t Telemetry;      //REFRESHED EVERY 50 ms, WATCH IN THE DEBUGGER
+uint8_t DumpHeld = 0;       //BUTTON 2 STATE, ONE PROFILE DUMP PER PRESS
 
 
 int main(void)
@@ -55,78 +211,288 @@ int main(void)
   Clock_Init48MHz();
   Motor_Init();
   Reflectance_Init();
-  SysTick_Init(48000, 2);
   LaunchPad_Init();
   BumpInt_Init(&collision);
-
-  StatePtr = Center;
+  TimerService_Init(2); //usec CALLBACKS ON TIMER A1, BELOW TIMER A2 SO THE WHEEL LOOP NEVER DELAYS A DECAY SAMPLE
+  Battery_Init();
+  WheelSpeed_Init(WHEEL_KFF, WHEEL_KP, WHEEL_KI, WHEEL_IMAX, WHEEL_OUTMAX);
 
   EnableInterrupts();
 
+  if((LaunchPad_Input() & 0x03) == 0x03) //BOTH BUTTONS HELD AT BOOT, MEASURE BRAKE AND COAST STOPS
+      stopBench();
+
+  if(LaunchPad_Input() & 0x02) //BUTTON 2 HELD AT BOOT, REJECT AMBIENT LIGHT THIS RUN
+      AmbientRun = REFLECTANCE_AMBIENT_DIFF;
+  Reflectance_SetAmbient(AmbientRun);
+
+  if(Calibration_Load() || (LaunchPad_Input() & 0x01)) //NO STORED PROFILE, OR BUTTON 1 HELD AT BOOT
+      calibrate();
+
+  State = FSM_START;
+  PID_Init(&LinePID, PID_KP, PID_KI, PID_KD, PID_ALPHA, PID_OUTMAX, PID_IMAX);
+  Planner_Init(&Planner, PLAN_MIN, PLAN_MAX, PLAN_ACCEL, PLAN_DECEL, PLAN_CURVE, PLAN_STRAIGHT);
+  LapMap_Init(); //FIRST LAP AFTER THE START BAR IS RECORDED, LATER LAPS RACE FROM THE MAP
+  Recovery_Init(&Rescue, REC_BASE, REC_TURN, REC_FULL, REC_EXTRAP_MS, REC_STRATEGY,
+                REC_LEG_MS, REC_LEGS, REC_SPIRAL_MS);
+  Avoid_Init(&Detour, AVOID_BRAKE_MS, AVOID_BACK_MS, AVOID_TURN_MS, AVOID_ARC_MS, AVOID_SEEK_MS,
+             AVOID_BACK_DUTY, AVOID_TURN_DUTY, AVOID_OUTER, AVOID_INNER, AVOID_SEEK_INNER);
+  Scheduler_Init(Tasks, sizeof(Tasks)/sizeof(Tasks[0]), TICK_CYCLES); //RUN TIMES AND OVERRUNS IN SchedStat
+#if TICKLESS
+  TickSpan = Scheduler_Stride(POWER_MAX_CYCLES/TICK_CYCLES);
+#endif
+  SysTick_Init(TickSpan*TICK_CYCLES, 2); //FIXED RELOAD, NEVER REWRITTEN WHILE COUNTING
+  Power_Init(TICK_CYCLES, TickSpan); //LPM0 RESIDENCY IN Power_Residency(), WAKEUPS IN PowerSpans
+
   while(1)
   {
-      WaitForInterrupt();
+      Power_Idle(Reflectance_Ready); //LPM0 UNTIL THE NEXT INTERRUPT, NOT WITH A FRAME WAITING
+      background();
   }
 }
 
-void motorState(uint8_t state) { //WHAT MOTORS DO IN EACH STATE
-    switch(state){
-        case 0x1:
-            Motor_Forward(3000, 3000);      //center
-            break;
-        case 0x2:
-            Motor_Left(0, 2000);            //left
-            break;
-        case 0x3:
-            Motor_Right(2000, 0);           //right
-            break;
-        case 0x4:
-            Motor_Forward(3000, 3000);      //look forward
-            Clock_Delay1ms(200);
-            break;
-        case 0x5:
-            Motor_Backward(3000, 3000);     //look backward
-            Clock_Delay1ms(200);
-            break;
-        case 0x6:
-            Motor_Left(2000, 2000); //look left
-            Clock_Delay1ms(300);
-            break;
-        case 0x7:
-            Motor_Right(2000, 2000); //look right
-            Clock_Delay1ms(300);
-        case 0x8:
-            Motor_Stop(); //lost catch all state
-            break;
-        case 0x9:
-            Motor_Left(4000, 4000); //fast turn left
-            break;
-        case 0xA:
-            Motor_Right(4000, 4000); //fast turn right
-            break;
-        default:
-            break;
+void background(void){ //MAIN LOOP WORK AFTER EVERY WAKEUP, SysTick AND THE TIMERS PREEMPT IT
+    BumpInt_Poll(); //DEBOUNCED BUMPS RUN collision() HERE, NOT IN THE PORT 4 ISR
+    controlTask(); //ACTS WHEN TIMER A2 HAS FINISHED A FRAME
+    if(LapMap_Build()) //FIRST LAP DONE, BUILD THE LOOK-AHEAD OUTSIDE THE ISR
+        LaunchPad_Output(0x02); //GREEN LED WHILE RACING FROM THE MAP
+#if PROFILE
+    if((LaunchPad_Input() & 0x02) && !DumpHeld) //BUTTON 2 PRESSED, FREEZE THE PROFILE IN ProfileDumped AND START OVER
+        Profile_Dump();
+    DumpHeld = LaunchPad_Input() & 0x02;
+#endif
+    if(LaunchPad_Input() & 0x01) { //BUTTON 1 PRESSED, RECALIBRATE WITH THE CONTROL LOOP STOPPED
+        SysTick->CTRL = 0;
+        wheelsOff(); //calibrate() DRIVES THE MOTORS ITSELF
+        calibrate();
+        State = FSM_START;
+        LapMap_Init(); //THE ROBOT WAS MOVED, RECORD THE TRACK AGAIN
+        SysTick_Init(TickSpan*TICK_CYCLES, 2);
+        Power_Init(TICK_CYCLES, TickSpan);
     }
 }
 
+void calibrate(void) { //SPIN OVER THE LINE AND SAVE THE SENSOR PROFILE, BLUE LED WHILE RUNNING
+    LaunchPad_Output(0x04);
+    CalResult = Calibration_Run();
+    LaunchPad_LED(CalResult != 0); //RED LED1 STAYS ON UNTIL A CALIBRATION SUCCEEDS
+    if(CalResult == 1)
+        LaunchPad_Output(0x01); //RED: A SENSOR SAW NO LINE, THE OLD PROFILE IS STILL IN USE
+    else if(CalResult == 2)
+        LaunchPad_Output(0x05); //MAGENTA: NEW PROFILE IN USE BUT NOT SAVED, LOST AT RESET
+    else
+        LaunchPad_Output(0x00);
+}
+
+void SysTick_Handler(void){ //EVERY PERIODIC JOB IS A ROW IN TASK_TABLE
+    PROFILE_TICK(); //CYCLES LATE AGAINST THE NOMINAL TICK
+    PROFILE_ENTER(PROFILE_SYSTICK);
+    uint16_t elapsed = Power_Elapsed(); //TickSpan TICKS, THE SAME EVERY PERIOD
+
+    Ticks += elapsed;
+    Scheduler_Tick(elapsed);
+    PROFILE_EXIT(PROFILE_SYSTICK);
+}
+
+
+void wheelTask(void){ //TIMER A1 EVERY WHEEL_MS WHILE THE WHEELS ARE COMMANDED OR STILL TURNING
+    WheelSpeed_Step(WHEEL_MS); //ENCODER SPEEDS AND WHEEL LOOPS
+    if(WheelSpeed_Still()) //STOPPED, NO TIMER A1 WAKEUPS UNTIL THE NEXT COMMAND
+        wheelsOff();
+}
+
+
+void wheelsOn(void){ //RESTART THE WHEEL LOOP IF IT PAUSED, CALLED WITH INTERRUPTS MASKED
+    if(WheelTimer == TIMER_NONE)
+        WheelTimer = TimerService_Every(WHEEL_MS*1000, wheelTask);
+}
+
 
-void SysTick_Handler(void){
-    volatile static uint8_t count = 0;
+void wheelsOff(void){ //PAUSE THE WHEEL LOOP, FROM ITS OWN EVENT OR THE MAIN LOOP
+    long sr = StartCritical();
+    TimerService_Cancel(WheelTimer); //NOTHING TO DO FOR TIMER_NONE
+    WheelTimer = TIMER_NONE;
+    EndCritical(sr);
+}
 
-    if(count % 10 == 0)
-        Reflectance_Start();
 
-    else if(count % 10 == 1) {
-                data = Reflectance_End();
-                Input = Reflectance_Position(data); //READ IN REFLECTANCE DATA AND CHANGE STATE
-                StatePtr = StatePtr->next[Input];
-                motorState(StatePtr->out);
+void senseTask(void){ //TIMER A2 CHARGES AND READS THE SENSORS IN THE BACKGROUND
+    if(AmbientRun == REFLECTANCE_AMBIENT_OFF)
+        Reflectance_StartCapture(CalProfile.window);
+    else
+        Reflectance_StartDecay(CalProfile.step, CalProfile.timeout); //ONE TA2 INTERRUPT PER STEP, SEE Reflectance.h
+}
+
+
+void controlTask(void){
+    PROFILE_ENTER(PROFILE_CONTROL);
+    uint8_t frame;
+    int32_t left, right;
+
+    if(!readLine(&frame)) { //NOTHING NEW SINCE THE LAST WAKEUP, ONE FRAME EVERY 10 ms
+        PROFILE_EXIT(PROFILE_CONTROL);
+        return;
     }
-    count++;
+    if(Detour.phase != AVOID_IDLE) { //DETOUR RUNNING, LINE CONTROL WAITS BUT FRAMES KEEP COMING
+        data = frame;
+        avoidControl();
+    }
+
+    else { //FRAME IS READY ABOUT 1 MS AFTER THE START
+                data = frame;
+                if(ActiveMode != ControlMode) { //CONTROLLER SWITCHED, START IT FRESH
+                    ActiveMode = ControlMode;
+                    State = FSM_START;
+                    PID_Reset(&LinePID);
+                }
+                LapMap_Update(data, LinePos, travelled()); //RECORD OR FOLLOW THE LAP MAP
+                Base = Planner_Step(&Planner, LinePos, LinePos == REFLECTANCE_NOLINE); //FAST ON STRAIGHTS, SLOW INTO CURVES
+                if(Base > LapMap_SpeedLimit(PLAN_MIN, PLAN_MAX)) //SLOW DOWN BEFORE A MAPPED CURVE, NOT IN IT
+                    Base = LapMap_SpeedLimit(PLAN_MIN, PLAN_MAX);
+                if(Recovery_Step(&Rescue, LinePos, LinePos == REFLECTANCE_NOLINE, Ticks, &left, &right)) {
+                    State = ST_Lost; //LINE LOST, THE RECOVERY ENGINE DRIVES UNTIL IT IS BACK
+                    PID_Reset(&LinePID);
+                    setWheels(left, right);
+                }
+                else if(ActiveMode == CONTROL_PID)
+                    pidControl(LinePos);
+                else {
+                    Input = Reflectance_Position(data); //READ IN REFLECTANCE DATA AND CHANGE STATE
+                    State = fsm[State].next[Input];
+                    if(State == ST_Center)
+                        setWheels(Base, Base);
+                    else
+                        setWheels(fsm[State].left, fsm[State].right);
+                }
+    }
+    PROFILE_EXIT(PROFILE_CONTROL);
+}
+
+
+void powerTask(void){
+    Motor_Supply(Battery_Millivolts()); //SCALE DUTIES FOR THE BATTERY LEVEL
+    Battery_Start(); //NEXT SAMPLE, READ IN THE ADC14 INTERRUPT
+    Timebase_Now(); //KEEP THE 64-BIT TIMEBASE AHEAD OF THE 89 s CYCCNT WRAP
+}
+
+
+void telemetryTask(void){
+    Telemetry.ms = Ticks;
+    Telemetry.linePos = LinePos;
+    Telemetry.base = Base;
+    Telemetry.speed[ENCODER_RIGHT] = Encoder_Speed(ENCODER_RIGHT);
+    Telemetry.speed[ENCODER_LEFT] = Encoder_Speed(ENCODER_LEFT);
+    Telemetry.millivolts = Battery_Millivolts();
+    Telemetry.state = State;
+    Telemetry.detour = Detour.phase;
+}
+
+
+uint32_t travelled(void){ //DISTANCE SINCE THE LAST CALL IN ENCODER TICKS, MEAN OF BOTH WHEELS
+    int32_t ticks = (Encoder_Ticks(ENCODER_LEFT) + Encoder_Ticks(ENCODER_RIGHT))/2;
+    int32_t moved = ticks - LapTicks;
+    LapTicks = ticks;
+    if(moved <= 0) //BACKING UP IS NOT PROGRESS AROUND THE LAP
+        return 0;
+    return moved;
 }
 
 
-void collision(uint8_t bump){
-    Motor_Stop(); //STOP IF BUMP IS DETECTED
+uint8_t readLine(uint8_t *frame){ //PICK UP A FINISHED FRAME FROM EITHER CAPTURE MODE
+    uint16_t time[8];
+
+    if(Reflectance_GetDecay(time)) {
+        *frame = Reflectance_Threshold(time, CalProfile.threshold); //AMBIENT CORRECTED DECAY TIMES
+        LinePos = Reflectance_DecayPosition(time);
+        return 1;
+    }
+    if(Reflectance_GetFrame(frame)) {
+        LinePos = Reflectance_Centroid(*frame); //UNWEIGHTED, 0x18 IS DEAD CENTER
+        return 1;
+    }
+    return 0;
+}
+
+
+void pidControl(int32_t position){ //DIFFERENTIAL DUTY FROM THE CONTINUOUS LINE POSITION
+    if(position != REFLECTANCE_NOLINE)
+        Correction = PID_Step(&LinePID, position); //POSITIVE IS LINE TO THE RIGHT, TURN RIGHT
+    //NO LINE NEVER GETS HERE, THE RECOVERY ENGINE DRIVES THEN
+    setWheels(Base + Correction + LapMap_FeedForward(), Base - Correction - LapMap_FeedForward()); //PLUS THE STEERING THE MAP EXPECTS
+}
+
+
+void setWheels(int32_t left, int32_t right){ //SIGNED DUTY PER WHEEL, NEGATIVE IS BACKWARD
+    if(left > DUTY_MAX) left = DUTY_MAX;
+    if(left < -DUTY_MAX) left = -DUTY_MAX;
+    if(right > DUTY_MAX) right = DUTY_MAX;
+    if(right < -DUTY_MAX) right = -DUTY_MAX;
+
+#if SPEED_LOOP
+    long sr = StartCritical(); //THE TIMER A1 WHEEL LOOP READS BOTH TARGETS
+    WheelSpeed_Set(left*WHEEL_FULL/PWM_SCALE, right*WHEEL_FULL/PWM_SCALE); //DUTY SCALE TO mm/s
+    wheelsOn();
+    EndCritical(sr);
+#else
+    Motor_Set(left, right); //DIRECTION FROM THE SIGN, NO BRANCHING HERE
+#endif
+}
+
+
+void collision(uint8_t bump){ //CALLED FROM THE MAIN LOOP, SO KEEP SysTick OUT WHILE SWITCHING OVER
+    long sr = StartCritical();
+    brakeWheels(); //HARD BRAKE IF BUMP IS DETECTED, THEN DETOUR ON THE NEXT FRAME
+    Avoid_Bump(&Detour, bump, (LinePos < 0) ? -1 : 1, Ticks); //CENTERED HIT, GO AROUND THE SIDE THE LINE BENDS TO
+    EndCritical(sr);
+}
+
+
+void brakeWheels(void){ //SHORT BOTH MOTORS NOW, LOOPS HOLD 0 UNTIL THE NEXT COMMAND
+#if SPEED_LOOP
+    long sr = StartCritical();
+    WheelSpeed_Brake();
+    wheelsOn(); //THE LOOPS HOLD THE BRAKE UNTIL THE WHEELS STOP
+    EndCritical(sr);
+#else
+    Motor_Brake();
+#endif
+}
+
+
+void avoidControl(void){ //BACK OFF, TURN AWAY AND ARC AROUND, THE LINE CONTROLLER PICKS UP WHERE IT LEFT OFF
+    int32_t left, right;
+    uint8_t phase = Avoid_Step(&Detour, data, Ticks, &left, &right);
+
+    if(phase != AVOID_IDLE && phase != AVOID_BRAKE) //BRAKE HOLDS THE SHORTED MOTORS FROM collision()
+        setWheels(left, right);
+    //IDLE: LINE FOUND, OR NOT FOUND AND THE RECOVERY ENGINE SEARCHES ON THE NEXT FRAME
+}
+
+
+void stopBench(void){ //DRIVE, STOP, AND RECORD TIME AND DISTANCE TO STANDSTILL, YELLOW LED WHILE RUNNING
+    uint8_t mode, run;
+    uint32_t ms;
+
+    LaunchPad_Output(0x03);
+    for(mode = BENCH_BRAKE; mode <= BENCH_COAST; mode++) {
+        for(run = 0; run < BENCH_RUNS; run++) {
+            WheelSpeed_Set(BENCH_SPEED, BENCH_SPEED);
+            for(ms = 0; ms < 1000; ms += WHEEL_MS) { //GET UP TO SPEED, SysTick IS NOT RUNNING YET
+                WheelSpeed_Step(WHEEL_MS);
+                Clock_Delay1ms(WHEEL_MS);
+            }
+            if(mode == BENCH_BRAKE)
+                WheelSpeed_Brake();
+            else
+                WheelSpeed_Stop();
+            for(ms = 0; ms < 2000 && !WheelSpeed_Stopping(&StopBenchMs[mode][run], &StopBenchUm[mode][run]); ms += WHEEL_MS) {
+                WheelSpeed_Step(WHEEL_MS);
+                Clock_Delay1ms(WHEEL_MS);
+            }
+            Motor_Stop();
+            Clock_Delay1ms(500);
+        }
+    }
+    LaunchPad_Output(0x00);
 }
 
@@ -0,0 +1,78 @@
+// InfoFlash.c
+// Runs on MSP432
+// Erase and program words in INFO flash bank 0 sector 0
+// through the flash controller, for small persistent records.
+// Must not run from the flash bank being modified; bank 0
+// INFO is separate from MAIN, so code in MAIN is fine.
+
+#include <stdint.h>
+#include "msp.h"
+#include "InfoFlash.h"
+
+// ------------InfoFlash_Erase------------
+// Erase INFO bank 0 sector 0 (4 KB) to all ones.
+// Input: none
+// Output: 0 on success, 1 on erase or verify error
+uint8_t InfoFlash_Erase(void){
+  const volatile uint32_t *p;
+  uint8_t error = 0;
+  FLCTL->BANK0_INFO_WEPROT &= ~0x00000001;  // unprotect sector 0
+  FLCTL->CLRIFG = 0x0000033F;               // clear stale flags
+  FLCTL->ERASE_CTLSTAT = 0x00000004;        // sector erase, INFO memory
+// bit  mode
+// 19   0     CLR_STAT
+// 3-2  01    TYPE, INFO memory
+// 1    0     MODE, sector erase
+// 0    0     START
+  FLCTL->ERASE_SECTADDR = INFOFLASH_SECTOR;
+  FLCTL->ERASE_CTLSTAT |= 0x00000001;       // start
+  while((FLCTL->ERASE_CTLSTAT&0x00030000) != 0x00030000){}; // STATUS 01 pending, 10 in progress, 11 complete
+  if(FLCTL->ERASE_CTLSTAT&0x00040000){
+    error = 1;                              // address error
+  }
+  FLCTL->ERASE_CTLSTAT = 0x00080000;        // clear status
+  FLCTL->BANK0_INFO_WEPROT |= 0x00000001;   // protect sector 0
+  for(p = (const volatile uint32_t *)INFOFLASH_RECORD;
+      p < (const volatile uint32_t *)(INFOFLASH_RECORD+INFOFLASH_SIZE); p++){
+    if(*p != 0xFFFFFFFF){
+      error = 1;                            // erase did not take
+    }
+  }
+  return error;
+}
+
+// ------------InfoFlash_Write------------
+// Program 32-bit words into an erased part of the record
+// area, one word at a time with pre and post verify.
+// Input: addr   destination, word aligned, inside the record area
+//        source words to write
+//        count  number of words
+// Output: 0 on success, 1 on bad address or program error
+uint8_t InfoFlash_Write(uint32_t addr, const uint32_t *source, uint32_t count){
+  volatile uint32_t *dest = (volatile uint32_t *)addr;
+  uint8_t error = 0;
+  uint32_t i;
+  if((addr&0x3) || (addr < INFOFLASH_RECORD) ||
+     (addr + 4*count > INFOFLASH_RECORD + INFOFLASH_SIZE)){
+    return 1;                               // bad input
+  }
+  FLCTL->BANK0_INFO_WEPROT &= ~0x00000001;  // unprotect sector 0
+  FLCTL->CLRIFG = 0x0000033F;               // clear stale flags
+  FLCTL->PRG_CTLSTAT = 0x0000000D;          // immediate word program, verify before and after
+// bit  mode
+// 3    1     VER_PST, post-program verify
+// 2    1     VER_PRE, pre-program verify
+// 1    0     MODE, immediate write
+// 0    1     ENABLE, word programming
+  for(i=0; i<count; i++){
+    dest[i] = source[i];                    // starts the program operation
+    while(FLCTL->PRG_CTLSTAT&0x00030000){}; // wait while program is in progress
+    if((FLCTL->IFG&0x00000206) || (dest[i] != source[i])){
+      error = 1;                            // verify or program error
+      break;
+    }
+  }
+  FLCTL->PRG_CTLSTAT = 0x00000000;          // disable word programming
+  FLCTL->BANK0_INFO_WEPROT |= 0x00000001;   // protect sector 0
+  return error;
+}
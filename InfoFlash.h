@@ -0,0 +1,32 @@
+// InfoFlash.h
+// Runs on MSP432
+// Erase and program words in INFO flash bank 0 sector 0
+// through the flash controller, for small persistent records.
+
+#ifndef INFOFLASH_H_
+#define INFOFLASH_H_
+#include <stdint.h>
+
+// Bank 0 sector 0 holds the flash mailbox in its first bytes;
+// records live in the upper half.  Erasing the sector also
+// blanks the mailbox, which the boot code reads as "no command".
+#define INFOFLASH_SECTOR  0x00200000
+#define INFOFLASH_RECORD  0x00200800
+#define INFOFLASH_SIZE    0x00000800
+
+// ------------InfoFlash_Erase------------
+// Erase INFO bank 0 sector 0 (4 KB) to all ones.
+// Input: none
+// Output: 0 on success, 1 on erase or verify error
+uint8_t InfoFlash_Erase(void);
+
+// ------------InfoFlash_Write------------
+// Program 32-bit words into an erased part of the record
+// area, one word at a time with pre and post verify.
+// Input: addr   destination, word aligned, inside the record area
+//        source words to write
+//        count  number of words
+// Output: 0 on success, 1 on bad address or program error
+uint8_t InfoFlash_Write(uint32_t addr, const uint32_t *source, uint32_t count);
+
+#endif /* INFOFLASH_H_ */
@@ -0,0 +1,146 @@
+// LapMap.c
+// Lap learning.  The first lap after the start/finish marker
+// records the line position against travelled distance; later
+// laps use the map to slow down ahead of each curve and to
+// feed the expected steering forward to the controller.
+// Each bin stores the mean line position in 256 um units as
+// a signed byte, so a 2048-bin lap needs 4 KB of SRAM with
+// the look-ahead table.
+
+#include <stdint.h>
+#include "Reflectance.h"
+#include "LapMap.h"
+
+#define LAP_MARKER  0xFF        // all sensors dark, start/finish bar
+#define LAP_DECAY   2           // look-ahead severity lost per bin
+#define LAP_LEAD    5           // bins of steering feed-forward lead
+#define LAP_FF_GAIN 27          // duty per 256 um of recorded position
+
+int8_t LapCurve[LAP_BINS];      // mean position per bin, 256 um units
+uint8_t LapAhead[LAP_BINS];     // worst |position| ahead, decayed with distance
+uint8_t LapMode = LAP_WAIT;
+uint16_t LapLength;
+uint16_t LapBin;
+uint32_t LapCount = 0;
+uint32_t LapTravel;             // travel units into the current bin
+int32_t LapSum;                 // position sum for the current bin
+uint16_t LapSamples;            // frames in the current bin
+uint8_t LapMarker;              // consecutive frames on the marker
+uint8_t LapArmed;               // 1 once the robot has left the marker
+
+// ------------LapMap_Init------------
+// Forget any map and wait for the start/finish marker.
+void LapMap_Init(void){
+  LapMode = LAP_WAIT;
+  LapLength = 0;
+  LapBin = 0;
+  LapCount = 0;
+  LapMarker = 0;
+  LapArmed = 0;
+}
+
+// close the current bin into the map while recording
+static void LapMap_Close(void){
+  int32_t mean = 0;
+  if(LapSamples){
+    mean = (LapSum/LapSamples) >> 8;          // 256 um units
+  }
+  if(mean > 127) mean = 127;
+  if(mean < -127) mean = -127;
+  LapCurve[LapBin] = mean;
+  LapSum = 0;
+  LapSamples = 0;
+}
+
+// start/finish marker crossed
+static void LapMap_Marker(void){
+  LapCount++;
+  if(LapMode == LAP_WAIT){
+    LapMode = LAP_RECORD;                     // lap one starts here
+  }else if(LapMode == LAP_RECORD){
+    LapMap_Close();
+    LapLength = LapBin + 1;
+    LapMode = LAP_BUILD;                      // main builds the look-ahead
+  }
+  LapBin = 0;
+  LapTravel = 0;
+  LapSum = 0;
+  LapSamples = 0;
+}
+
+// ------------LapMap_Update------------
+// Advance along the lap once per control frame.
+void LapMap_Update(uint8_t data, int32_t position, uint32_t travel){
+  if(data == LAP_MARKER){
+    if(LapMarker < 2) LapMarker++;
+    if(LapMarker == 2 && LapArmed){
+      LapArmed = 0;                           // one count per crossing
+      LapMap_Marker();
+    }
+  }else{
+    LapMarker = 0;
+    LapArmed = 1;
+  }
+  if(LapMode == LAP_WAIT){
+    return;
+  }
+  if(LapMode == LAP_RECORD && data != 0 && position != REFLECTANCE_NOLINE){
+    LapSum += position;
+    LapSamples++;
+  }
+  LapTravel += travel;
+  while(LapTravel >= LAP_BIN){                // at most a bin or two per frame
+    LapTravel -= LAP_BIN;
+    if(LapMode == LAP_RECORD){
+      LapMap_Close();
+      if(LapBin == LAP_BINS-1){
+        LapMode = LAP_WAIT;                   // lap too long for the map, give up
+        return;
+      }
+    }
+    if(LapBin < LAP_BINS-1) LapBin++;
+  }
+}
+
+// ------------LapMap_Build------------
+// Build the look-ahead table after the first lap.
+uint8_t LapMap_Build(void){
+  int32_t i, ahead, here;
+  if(LapMode != LAP_BUILD){
+    return 0;
+  }
+  // the lap is a loop, so the bins past the end lead into bin 0:
+  // the first pass carries the curves at the start of the lap
+  // around to the end, the second one writes the table
+  ahead = 0;
+  for(i=2*LapLength-1; i>=0; i--){
+    here = (LapCurve[i%LapLength] < 0) ? -LapCurve[i%LapLength] : LapCurve[i%LapLength];
+    ahead = (ahead > LAP_DECAY) ? ahead - LAP_DECAY : 0;
+    if(here > ahead) ahead = here;
+    if(i < LapLength) LapAhead[i] = ahead;
+  }
+  LapMode = LAP_RACE;
+  return 1;
+}
+
+// ------------LapMap_SpeedLimit------------
+// Highest base duty allowed for the curves ahead.
+int32_t LapMap_SpeedLimit(int32_t minBase, int32_t maxBase){
+  if(LapMode != LAP_RACE || LapBin >= LapLength){
+    return maxBase;
+  }
+  return maxBase - ((LapAhead[LapBin]*(maxBase - minBase)) >> 7);
+}
+
+// ------------LapMap_FeedForward------------
+// Steering expected a few bins ahead.
+int32_t LapMap_FeedForward(void){
+  uint16_t bin = LapBin + LAP_LEAD;
+  if(LapMode != LAP_RACE || LapBin >= LapLength){
+    return 0;
+  }
+  if(bin >= LapLength){
+    bin -= LapLength;                         // the start of the next lap
+  }
+  return LapCurve[bin]*LAP_FF_GAIN;
+}
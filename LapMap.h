@@ -0,0 +1,66 @@
+// LapMap.h
+// Lap learning.  The first lap after the start/finish marker
+// records the line position against travelled distance; later
+// laps use the map to slow down ahead of each curve and to
+// feed the expected steering forward to the controller.
+// No hardware access, so a simulated track can drive it on
+// the host.
+
+#ifndef LAPMAP_H_
+#define LAPMAP_H_
+#include <stdint.h>
+
+#define LAP_BINS   2048         // map length, 2 KB each for curve and ahead
+#define LAP_BIN    16           // travel units per bin, 16 encoder ticks is 1 cm
+
+#define LAP_WAIT   0            // waiting for the start/finish marker
+#define LAP_RECORD 1            // first lap, building the map
+#define LAP_BUILD  2            // map recorded, look-ahead not built yet
+#define LAP_RACE   3            // later laps, driving from the map
+
+// state of the learner, readable from the debugger
+extern uint8_t LapMode;
+extern uint16_t LapLength;      // bins in the recorded lap
+extern uint16_t LapBin;         // bin the robot is in now
+extern uint32_t LapCount;       // start/finish markers crossed
+
+// ------------LapMap_Init------------
+// Forget any map and wait for the start/finish marker.
+// Input: none
+// Output: none
+void LapMap_Init(void);
+
+// ------------LapMap_Update------------
+// Advance along the lap once per control frame.  The
+// start/finish marker is all eight sensors dark for two frames.
+// Input: data      8-bit sensor reading
+//        position  line position in microns (ignored when data is 0
+//                  or position is REFLECTANCE_NOLINE)
+//        travel    distance covered since the last call, in travel
+//                  units (encoder ticks)
+// Output: none
+void LapMap_Update(uint8_t data, int32_t position, uint32_t travel);
+
+// ------------LapMap_Build------------
+// Build the look-ahead table after the first lap.  Two
+// backward passes around the loop, so the look-ahead at the
+// end of the lap sees the curves at its start; run from main,
+// not from the ISR.
+// Input: none
+// Output: 1 if the table was built on this call, 0 if nothing to do
+uint8_t LapMap_Build(void);
+
+// ------------LapMap_SpeedLimit------------
+// Highest base duty allowed for the curves ahead.
+// Input: minBase, maxBase  range of the speed planner
+// Output: maxBase outside LAP_RACE or past the recorded lap
+int32_t LapMap_SpeedLimit(int32_t minBase, int32_t maxBase);
+
+// ------------LapMap_FeedForward------------
+// Steering expected a few bins ahead, from the recorded
+// line position, in duty units to add to the PID correction.
+// Input: none
+// Output: 0 outside LAP_RACE or past the recorded lap
+int32_t LapMap_FeedForward(void);
+
+#endif /* LAPMAP_H_ */
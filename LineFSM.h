@@ -0,0 +1,37 @@
+// LineFSM.h
+// Declarative description of the line-following state machine.
+// FSM_Main.c compiles it into one flat const table of duty pairs
+// and next-state indices, and rejects at compile time
+// any state that cannot be reached from LINE_FSM_START.
+//
+// One row per state:
+//   STATE(X, name, left, right, next0, ..., next6)
+//     X          passed through, used by the table compiler
+//     left,right signed wheel duty, negative is backward (|duty| < PWM_SCALE),
+//                driven until the next frame decides again
+//     nextN      state to go to on input class N from Reflectance_Position()
+// Every row must list all seven inputs; a missing one is a macro
+// argument count error, an unknown name an undeclared identifier.
+// While in Lost the recovery engine (Recovery.h) drives the wheels
+// instead of the row's duty pair.
+
+#ifndef LINEFSM_H_
+#define LINEFSM_H_
+
+#define LINE_FSM_INPUTS 7
+// input classes
+//   0 forward      1 right        2 left         3 centered
+//   4 hard left    5 hard right   6 line lost
+
+#define LINE_FSM(STATE, X) \
+/*      X  name    left   right  forward right  left   centered hardL  hardR  lost  */ \
+  STATE(X, Center,  4000,  4000, Center, Left,  Right, Center,  FastL, FastR, Lost ) \
+  STATE(X, Left,       0,  2667, Center, Left,  Right, Center,  FastL, FastR, Lost ) \
+  STATE(X, Right,   2667,     0, Center, Left,  Right, Center,  FastL, FastR, Lost ) \
+  STATE(X, Lost,       0,     0, Center, Left,  Right, Center,  FastL, FastR, Lost ) \
+  STATE(X, FastL,  -5333,  5333, Center, Left,  Right, Center,  FastL, FastR, Lost ) \
+  STATE(X, FastR,   5333, -5333, Center, Left,  Right, Center,  FastL, FastR, Lost )
+
+#define LINE_FSM_START Center
+
+#endif /* LINEFSM_H_ */
@@ -1,15 +1,37 @@
 #include <stdint.h>
 #include "msp.h"
-#include "../inc/CortexM.h"
-#include "../inc/PWM.h"
+#include "CortexM.h"
+#include "PWM.h"
+#include "Motor.h"
+
+#define MOTOR_PWM_HZ    20000   // above hearing, no whine
+#define MOTOR_PWM_STEPS 256     // fewest duty steps, 20 kHz gives 300
+#define MOTOR_DEAD_US   100     // off time before a wheel reverses
+#define MOTOR_ACCEL     100     // duty per ms, 0 to full in 100 ms
+#define MOTOR_DECEL     200     // duty per ms, full to 0 in 50 ms
+#define MOTOR_REVERSE   100     // duty per ms down to 0 before reversing
+#define MOTOR_NOMINAL_MV 7200   // battery voltage the duties were tuned at
+#define MOTOR_SCALE_MIN 49152   // Q16 0.75, full pack
+#define MOTOR_SCALE_MAX 98304   // Q16 1.5, pack nearly empty
+
+// single-bit aliases, no read-modify-write of the whole port
+#define LEFT_DIR    BITBAND_PERI(P5->OUT, 4)
+#define RIGHT_DIR   BITBAND_PERI(P5->OUT, 5)
+#define RIGHT_SLEEP BITBAND_PERI(P3->OUT, 6)
+#define LEFT_SLEEP  BITBAND_PERI(P3->OUT, 7)
+
+int32_t LastLeft, LastRight;    // last command staged
+uint8_t Awake = 0;              // 1 while the drivers are out of sleep
+uint32_t MotorSkipped = 0;
+uint32_t MotorScale = 65536;    // Q16 battery compensation, 1.0 off
 
 // ------------Motor_Init------------
 // Initialize GPIO pins for output, which will be
 // used to control the direction of the motors and
 // to enable or disable the drivers.
 // The motors are initially stopped, the drivers
-// are initially powered down, and the PWM speed
-// control is uninitialized.
+// are initially powered down, and the PWM runs
+// at 20 kHz with 0% duty cycle.
 // Input: none
 // Output: none
 void Motor_Init(void){
@@ -24,6 +46,7 @@ void Motor_Init(void){
     P3->SEL1 &= ~0xC0;
     P3->DIR |= 0xC0;
     P3->OUT &= ~0xC0; //sleep motors
+    Awake = 0;
 
     //PWM pins P2.6, P2.7
     P2->SEL0 &= ~0xC0;
@@ -31,7 +54,63 @@ void Motor_Init(void){
     P2->DIR |= 0xC0;
     P2->OUT &= ~0xC0;
 
-    PWM_Init12(7500,0,0);
+    PWM_Config(MOTOR_PWM_HZ, MOTOR_PWM_STEPS);
+    PWM_Slew(MOTOR_ACCEL, MOTOR_DECEL, MOTOR_REVERSE); //NO WHEEL SLIP OR CURRENT SPIKES
+    Motor_DeadTime(MOTOR_DEAD_US);
+}
+
+// ------------Motor_DeadTime------------
+// Set how long a wheel is held at 0% duty cycle before it
+// changes direction, rounded up to whole PWM periods.
+// Input: us  dead time in usec, 0 for none
+// Output: none
+void Motor_DeadTime(uint32_t us){
+    uint32_t periods = (us*MOTOR_PWM_HZ + 999999)/1000000;
+    PWM_Phase(&RIGHT_DIR, &LEFT_DIR, periods);
+}
+
+// ------------Motor_Set------------
+// Drive each wheel with a signed duty cycle, negative is
+// backward.
+// Input: left   duty cycle of left wheel (-9,999 to 9,999)
+//        right  duty cycle of right wheel (-9,999 to 9,999)
+// Output: none
+// Assumes: Motor_Init() has been called
+void Motor_Set(int32_t left, int32_t right){
+    left = ((int64_t)left*MotorScale) >> 16;   //SAME WHEEL VOLTAGE AT ANY BATTERY LEVEL
+    right = ((int64_t)right*MotorScale) >> 16;
+    if(left > PWM_SCALE-1) left = PWM_SCALE-1;
+    if(left < -(PWM_SCALE-1)) left = -(PWM_SCALE-1);
+    if(right > PWM_SCALE-1) right = PWM_SCALE-1;
+    if(right < -(PWM_SCALE-1)) right = -(PWM_SCALE-1);
+
+    if(Awake && left == LastLeft && right == LastRight){
+        MotorSkipped++;       //nothing changed, no register writes
+        return;
+    }
+    LastLeft = left;
+    LastRight = right;
+    PWM_Stage((right < 0) ? -right : right, (left < 0) ? -left : left,
+              right < 0, left < 0); //PH = 1 is backward, committed at the period boundary
+    if(!Awake){
+        RIGHT_SLEEP = 1;      //nSleep = 1
+        LEFT_SLEEP = 1;
+        Awake = 1;
+    }
+}
+
+// ------------Motor_Supply------------
+// Report the battery voltage for duty compensation.
+// Input: mv  battery voltage in mV, 0 to turn compensation off
+// Output: none
+void Motor_Supply(uint32_t mv){
+    uint32_t scale = 65536;
+    if(mv){
+        scale = (MOTOR_NOMINAL_MV << 16)/mv;
+        if(scale < MOTOR_SCALE_MIN) scale = MOTOR_SCALE_MIN;
+        if(scale > MOTOR_SCALE_MAX) scale = MOTOR_SCALE_MAX;
+    }
+    MotorScale = scale;
 }
 
 // ------------Motor_Stop------------
@@ -42,69 +121,70 @@ void Motor_Init(void){
 void Motor_Stop(void){
 
       P2->OUT &= ~0xC0;//off
-      P3->OUT &= ~0xC0;//low current sleep mode
+      PWM_Halt();//0% duty now, no ramp
+      RIGHT_SLEEP = 0;//low current sleep mode
+      LEFT_SLEEP = 0;
+      Awake = 0;
 
 }
 
+// ------------Motor_Brake------------
+// Brake: 0% duty cycle now with the drivers awake.
+// Input: none
+// Output: none
+void Motor_Brake(void){
+      PWM_Halt();//0% duty now, DRV8838 EN low drives both outputs low
+      RIGHT_SLEEP = 1;//nSleep = 1, outputs driven, not floating
+      LEFT_SLEEP = 1;
+      LastLeft = 0;
+      LastRight = 0;
+      Awake = 1;
+}
+
 // ------------Motor_Forward------------
 // Drive the robot forward by running left and
 // right wheels forward with the given duty
 // cycles.
-// Input: leftDuty  duty cycle of left wheel (0 to 14,998)
-//        rightDuty duty cycle of right wheel (0 to 14,998)
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Forward(uint16_t leftDuty, uint16_t rightDuty){
-
-        P5->OUT &= ~0x30;
-        P3->OUT |= 0xC0;
-        PWM_Duty1(rightDuty);
-        PWM_Duty2(leftDuty);
+    Motor_Set(leftDuty, rightDuty);
 }
 
 // ------------Motor_Right------------
 // Turn the robot to the right by running the
 // left wheel forward and the right wheel
 // backward with the given duty cycles.
-// Input: leftDuty  duty cycle of left wheel (0 to 14,998)
-//        rightDuty duty cycle of right wheel (0 to 14,998)
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Right(uint16_t leftDuty, uint16_t rightDuty){
-
-    P3 -> OUT |= 0xC0;//nSleep = 1
-    P5 -> OUT &= ~0x10;//P5.4 PH = 0
-    P5 -> OUT |= 0x20; //P5.5 PH = 1
-    PWM_Duty2(leftDuty);
-    PWM_Duty1(rightDuty);
-
+    Motor_Set(leftDuty, -(int32_t)rightDuty);
 }
 
 // ------------Motor_Left------------
 // Turn the robot to the left by running the
 // left wheel backward and the right wheel
 // forward with the given duty cycles.
-// Input: leftDuty  duty cycle of left wheel (0 to 14,998)
-//        rightDuty duty cycle of right wheel (0 to 14,998)
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
 // Output: none
 // Assumes: Motor_Init() has been called
 void Motor_Left(uint16_t leftDuty, uint16_t rightDuty){
-
-    P3 -> OUT |= 0xC0;//nSleep = 1
-    P5 -> OUT |= 0x10;//P5.4 PH = 1
-    P5 -> OUT &= ~0x20;//P5.5 PH = 0
-    PWM_Duty2(leftDuty);
-    PWM_Duty1(rightDuty);
-
+    Motor_Set(-(int32_t)leftDuty, rightDuty);
 }
 
+// ------------Motor_Backward------------
+// Drive the robot backward by running left and
+// right wheels backward with the given duty
+// cycles.
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
+// Output: none
+// Assumes: Motor_Init() has been called
 void Motor_Backward(uint16_t leftDuty, uint16_t rightDuty){
-
-   P3->OUT |= 0xC0;//nSleep = 1
-   P5->OUT |= 0x30;//PH = 1
-   PWM_Duty1(rightDuty);
-   PWM_Duty2(leftDuty);
-
+    Motor_Set(-(int32_t)leftDuty, -(int32_t)rightDuty);
 }
-
-
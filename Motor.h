@@ -0,0 +1,108 @@
+// Motor.h
+// Drive the two DRV8838 motor drivers on the RSLK.
+// Right motor: PWM P2.6, direction P5.5, nSLEEP P3.6
+// Left motor:  PWM P2.7, direction P5.4, nSLEEP P3.7
+// Duty cycles are in PWM_SCALE units (PWM.h), 10000 is 100%.
+
+#ifndef MOTOR_H_
+#define MOTOR_H_
+#include <stdint.h>
+
+// ------------Motor_Init------------
+// Initialize GPIO pins for output, which will be
+// used to control the direction of the motors and
+// to enable or disable the drivers.
+// The motors are initially stopped, the drivers
+// are initially powered down, and the PWM runs
+// at 20 kHz with 0% duty cycle.
+// Input: none
+// Output: none
+void Motor_Init(void);
+
+// ------------Motor_Set------------
+// Drive each wheel with a signed duty cycle, negative is
+// backward.  Direction pins are written with single-bit
+// bit-band stores at the PWM period boundary, after the
+// dead time if a wheel reverses.  Duties are scaled for the
+// battery voltage given to Motor_Supply(), then ramp to the new
+// command within the slew limits set in Motor_Init().  A
+// command equal to the previous one writes no registers.
+// Input: left   duty cycle of left wheel (-9,999 to 9,999)
+//        right  duty cycle of right wheel (-9,999 to 9,999)
+// Output: none
+// Assumes: Motor_Init() has been called
+void Motor_Set(int32_t left, int32_t right);
+
+// ------------Motor_DeadTime------------
+// Set how long a wheel is held at 0% duty cycle before it
+// changes direction, rounded up to whole PWM periods.
+// Input: us  dead time in usec, 0 for none
+// Output: none
+void Motor_DeadTime(uint32_t us);
+
+// ------------Motor_Supply------------
+// Report the battery voltage, so Motor_Set() can scale its
+// duties by MOTOR_NOMINAL_MV/mv and the wheels see the same
+// average voltage across the discharge curve.  Applies from
+// the next Motor_Set().
+// Input: mv  battery voltage in mV, 0 to turn compensation off
+// Output: none
+void Motor_Supply(uint32_t mv);
+
+// ------------Motor_Stop------------
+// Stop the motors, power down the drivers, and
+// set the PWM speed control to 0% duty cycle.
+// Coast: the outputs float and the wheels roll
+// to a stop.  Bypasses the slew-rate limits.
+// Input: none
+// Output: none
+void Motor_Stop(void);
+
+// ------------Motor_Brake------------
+// Brake: 0% duty cycle now with the drivers awake, so
+// both motor terminals are shorted low and the back EMF
+// stops the wheels.  Bypasses the slew-rate limits.
+// Input: none
+// Output: none
+void Motor_Brake(void);
+
+// ------------Motor_Forward------------
+// Drive the robot forward by running left and
+// right wheels forward with the given duty
+// cycles.
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
+// Output: none
+void Motor_Forward(uint16_t leftDuty, uint16_t rightDuty);
+
+// ------------Motor_Right------------
+// Turn the robot to the right by running the
+// left wheel forward and the right wheel
+// backward with the given duty cycles.
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
+// Output: none
+void Motor_Right(uint16_t leftDuty, uint16_t rightDuty);
+
+// ------------Motor_Left------------
+// Turn the robot to the left by running the
+// left wheel backward and the right wheel
+// forward with the given duty cycles.
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
+// Output: none
+void Motor_Left(uint16_t leftDuty, uint16_t rightDuty);
+
+// ------------Motor_Backward------------
+// Drive the robot backward by running left and
+// right wheels backward with the given duty
+// cycles.
+// Input: leftDuty  duty cycle of left wheel (0 to 9,999)
+//        rightDuty duty cycle of right wheel (0 to 9,999)
+// Output: none
+void Motor_Backward(uint16_t leftDuty, uint16_t rightDuty);
+
+// commands Motor_Set() found unchanged and skipped
+extern uint32_t MotorSkipped;
+
+#endif /* MOTOR_H_ */
@@ -0,0 +1,69 @@
+// PID.c
+// Fixed-point PID controller for line tracking.
+// Gains and filter coefficient are Q16 (65536 = 1.0); error
+// is the line position in microns and the output is a
+// differential duty in the units of Motor_Forward().
+// Products are taken in 64 bits (one SMULL on the Cortex-M4),
+// so there is no divide in the step.
+
+#include <stdint.h>
+#include "PID.h"
+
+// ------------PID_Init------------
+// Set the gains and limits and clear the controller state.
+void PID_Init(PID_t *pid, int32_t kp, int32_t ki, int32_t kd,
+              int32_t alpha, int32_t outMax, int32_t integralMax){
+  pid->kp = kp;
+  pid->ki = ki;
+  pid->kd = kd;
+  pid->alpha = alpha;
+  pid->outMax = outMax;
+  pid->integralMax = integralMax;
+  PID_Reset(pid);
+}
+
+// ------------PID_Reset------------
+// Clear the integral and derivative history.
+void PID_Reset(PID_t *pid){
+  pid->integral = 0;
+  pid->lastError = 0;
+  pid->derivative = 0;
+  pid->primed = 0;
+}
+
+// limit x to +/-max
+static int64_t PID_Clamp(int64_t x, int64_t max){
+  if(x > max) return max;
+  if(x < -max) return -max;
+  return x;
+}
+
+// ------------PID_Step------------
+// Run one control step.
+int32_t PID_Step(PID_t *pid, int32_t error){
+  int64_t p, d, integral, out;
+  int32_t change;
+
+  if(pid->primed == 0){
+    pid->lastError = error;           // no derivative kick on the first step
+    pid->primed = 1;
+  }
+  change = error - pid->lastError;
+  pid->lastError = error;
+  // derivative = alpha*derivative + (1-alpha)*change, Q16
+  pid->derivative = (pid->alpha*pid->derivative +
+                     (int64_t)(PID_ONE - pid->alpha)*change*PID_ONE) >> 16;
+
+  p = (int64_t)pid->kp*error;                     // Q16
+  d = ((int64_t)pid->kd*pid->derivative) >> 16;   // Q16
+  integral = PID_Clamp(pid->integral + (int64_t)pid->ki*error,
+                       (int64_t)pid->integralMax << 16);
+  out = (p + integral + d) >> 16;
+
+  // anti-windup: keep the new integral unless the output is
+  // saturated and the error would drive it further out
+  if(!((out > pid->outMax && error > 0) || (out < -pid->outMax && error < 0))){
+    pid->integral = integral;
+  }
+  return (int32_t)PID_Clamp(out, pid->outMax);
+}
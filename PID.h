@@ -0,0 +1,55 @@
+// PID.h
+// Fixed-point PID controller for line tracking.
+// Gains and filter coefficient are Q16 (65536 = 1.0); error
+// is the line position in microns and the output is a
+// differential duty in the units of Motor_Forward().
+// No hardware access, so it also builds on the host.
+
+#ifndef PID_H_
+#define PID_H_
+#include <stdint.h>
+
+#define PID_ONE 65536           // 1.0 in Q16
+
+struct PID {
+  int32_t kp;                   // Q16 duty per micron
+  int32_t ki;                   // Q16 duty per micron per step
+  int32_t kd;                   // Q16 duty per micron change per step
+  int32_t alpha;                // Q16 derivative filter, 0 none to PID_ONE frozen
+  int32_t outMax;               // output saturates at +/-outMax
+  int32_t integralMax;          // integral term clamps at +/-integralMax
+  int64_t integral;             // Q16 sum of ki*error
+  int32_t lastError;            // error on the previous step
+  int64_t derivative;           // Q16 filtered error change
+  uint8_t primed;               // 0 until the first step
+};
+typedef struct PID PID_t;
+
+// ------------PID_Init------------
+// Set the gains and limits and clear the controller state.
+// Input: pid          controller to initialize
+//        kp, ki, kd   Q16 gains
+//        alpha        Q16 derivative low-pass coefficient
+//        outMax       output saturation, duty
+//        integralMax  integral term limit, duty
+// Output: none
+void PID_Init(PID_t *pid, int32_t kp, int32_t ki, int32_t kd,
+              int32_t alpha, int32_t outMax, int32_t integralMax);
+
+// ------------PID_Reset------------
+// Clear the integral and derivative history, for example
+// after the line was lost or the controller was switched in.
+// Input: pid  controller
+// Output: none
+void PID_Reset(PID_t *pid);
+
+// ------------PID_Step------------
+// Run one control step.  The integral only accumulates while
+// the output is not pushed further into saturation (anti-windup),
+// and the derivative is low-pass filtered.
+// Input: pid    controller
+//        error  setpoint minus measurement, microns
+// Output: saturated control output, duty
+int32_t PID_Step(PID_t *pid, int32_t error);
+
+#endif /* PID_H_ */
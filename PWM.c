@@ -1,7 +1,98 @@
 #include "msp.h"
+#include "PWM.h"
+#include "Profile.h"
+
+// ramp state per channel, [0] is CCR3 (duty1), [1] is CCR4 (duty2)
+int32_t Target[2];                     // staged signed duty, counts, negative is phase 1
+uint32_t Level[2];                     // duty on the output now, Q8 counts
+uint8_t Sign[2];                       // phase bit on the pin now
+uint16_t Dead[2];                      // periods held at 0 so far in a reversal
+volatile uint32_t *Phase[2];           // bit-band direction pins, 0 for none
+uint16_t DeadPeriods = 0;              // periods at 0 duty on a reversal
+uint32_t PwmHz;                        // PWM frequency
+uint16_t SlewRate[3] = {0, 0, 0};      // accel, decel, reverse in PWM_SCALE units per ms
+uint32_t SlewStep[3];                  // the same in Q8 counts per period, 0 unlimited
+volatile uint8_t ShadowPending = 0;    // 1 until the staged duties are reached
+volatile uint32_t PwmCommits = 0;
+uint32_t PwmCoalesced = 0;
+uint32_t PwmDropped = 0;
+uint32_t PwmReversals = 0;
+
+#define SLEW_ACCEL   0
+#define SLEW_DECEL   1
+#define SLEW_REVERSE 2
+
+// rates in PWM_SCALE units per ms to Q8 counts per PWM period
+static void PWM_SlewSteps(void){
+  int i;
+  for(i=0; i<3; i++){
+    SlewStep[i] = ((uint64_t)SlewRate[i]*TIMER_A0->CCR[0]*256*1000)/((uint64_t)PWM_SCALE*PwmHz);
+    if(SlewRate[i] && SlewStep[i] == 0) SlewStep[i] = 1; // slowest ramp, never stuck
+  }
+}
+
+// set the period and divider and start the timer, both outputs at 0
+static void PWM_Start(uint16_t period, uint16_t id, uint16_t ex){
+  P2->DIR |= 0xC0;                // P2.6, P2.7 output
+  P2->SEL0 |= 0xC0;               // P2.6, P2.7 Timer0A functions
+  P2->SEL1 &= ~(0xC0);            // P2.6, P2.7 Timer0A functions
+  TIMER_A0->CTL = 0x0004;         // halt and clear while reconfiguring
+  TIMER_A0->CCTL[0] = 0x0080;     // CCI0 toggle, no interrupt until PWM_Stage
+  ShadowPending = 0;
+  Target[0] = Target[1] = 0;
+  Level[0] = Level[1] = 0;
+  Dead[0] = Dead[1] = 0;
+  TIMER_A0->CCR[0] = period;      // Period is 2*period*divider*83.33ns
+  TIMER_A0->EX0 = ex;             //    divide by ex+1
+  TIMER_A0->CCTL[3] = 0x0040;     // CCR3 toggle/reset
+  TIMER_A0->CCR[3] = 0;           // CCR3 duty cycle is CCR3/period
+  TIMER_A0->CCTL[4] = 0x0040;     // CCR4 toggle/reset
+  TIMER_A0->CCR[4] = 0;           // CCR4 duty cycle is CCR4/period
+  TIMER_A0->CTL = 0x0230|(id<<6); // SMCLK=12MHz, divide by 2^id, up-down mode
+// bit  mode
+// 9-8  10    TASSEL, SMCLK=12MHz
+// 7-6  id    ID, divide by 1, 2, 4 or 8
+// 5-4  11    MC, up-down mode
+// 2    0     TACLR, no clear
+// 1    0     TAIE, no interrupt
+// 0          TAIFG
+  PwmHz = PWM_CLOCK/(2*(1<<id)*(ex+1)*(uint32_t)period);
+  PWM_SlewSteps();
+  NVIC->IP[2] = (NVIC->IP[2]&0xFFFFFF00)|0x00000020; // priority 1
+  NVIC->ISER[0] = 0x00000100;     // enable interrupt 8 in NVIC
+}
+
+//***************************PWM_Config*******************************
+// PWM outputs on P2.6, P2.7 at a requested frequency
+// Inputs:  hz, PWM frequency
+//          resolution, fewest duty steps acceptable
+// Outputs: 0 if configured, 1 if not possible
+// Counter counts up to TA0CCR0 and back down, so the
+// PWM frequency is 12MHz/(2*divider*period).  The divider
+// is 2^ID (1 to 8) times EX0+1 (1 to 8).
+// 20 kHz: divider 1, period 300, 300 duty steps
+// 100 Hz: divider 1, period 60000, 60000 duty steps
+// 10 Hz:  divider 10, period 60000
+uint8_t PWM_Config(uint32_t hz, uint32_t resolution){
+  uint32_t divider, id, period;
+  if(hz == 0) return 1;           // bad input
+  for(divider=1; divider<=64; divider++){
+    for(id=0; id<4; id++){        // divider = 2^id*(ex+1), ex+1 up to 8
+      if((divider%(1<<id) == 0) && (divider>>id) <= 8) break;
+    }
+    if(id == 4) continue;         // not a product of ID and EX0
+    period = PWM_CLOCK/(2*divider*hz);
+    if(period <= 0xFFFF){
+      if(period < resolution || period < 2) return 1; // frequency too high for the resolution
+      PWM_Start(period, id, (divider>>id) - 1);
+      return 0;
+    }
+  }
+  return 1;                       // frequency too low for the 16-bit period
+}
 
 //***************************PWM_Init12*******************************
-// PWM outputs on P2.4, P2.5
+// PWM outputs on P2.6, P2.7
 // Inputs:  period (1.333us)
 //          duty1
 //          duty2
@@ -9,50 +100,180 @@
 // SMCLK = 48MHz/4 = 12 MHz, 83.33ns
 // Counter counts up to TA0CCR0 and back down
 // Let Timerclock period T = 8/12MHz = 666.7ns
-// P2.4=1 when timer equals TA0CCR1 on way down, P2.4=0 when timer equals TA0CCR1 on way up
-// P2.5=1 when timer equals TA0CCR2 on way down, P2.5=0 when timer equals TA0CCR2 on way up
-// Period of P2.4 is period*1.333us, duty cycle is duty1/period
-// Period of P2.5 is period*1.333us, duty cycle is duty2/period
+// Period of P2.6 is period*1.333us, duty cycle is duty1/period
+// Period of P2.7 is period*1.333us, duty cycle is duty2/period
 void PWM_Init12(uint16_t period, uint16_t duty1, uint16_t duty2){
   if(duty1 >= period) return;     // bad input
   if(duty2 >= period) return;     // bad input
-  P2->DIR |= 0xC0;                // P2.6, P2.7 output
-  P2->SEL0 |= 0xC0;               // P2.6, P2.7 Timer0A functions
-  P2->SEL1 &= ~(0xC0);            // P2.6, P2.7 Timer0A functions
-  TIMER_A0->CCTL[0] = 0x0080;     // CCI0 toggle
-  TIMER_A0->CCR[0] = period;      // Period is 2*period*8*83.33ns is 1.333*period
-  TIMER_A0->EX0 = 0x0000;         //    divide by 1
-  TIMER_A0->CCTL[3] = 0x0040;     // CCR1 toggle/reset
-  TIMER_A0->CCR[3] = duty1;       // CCR1 duty cycle is duty1/period
-  TIMER_A0->CCTL[4] = 0x0040;     // CCR2 toggle/reset
-  TIMER_A0->CCR[4] = duty2;       // CCR2 duty cycle is duty2/period
-  TIMER_A0->CTL = 0x02F0;         // SMCLK=12MHz, divide by 8, up-down mode
-// bit  mode
-// 9-8  10    TASSEL, SMCLK=12MHz
-// 7-6  11    ID, divide by 8
-// 5-4  11    MC, up-down mode
-// 2    0     TACLR, no clear
-// 1    0     TAIE, no interrupt
-// 0          TAIFG
+  PWM_Start(period, 3, 0);        // divide by 8
+  TIMER_A0->CCR[3] = duty1;       // CCR3 duty cycle is duty1/period
+  TIMER_A0->CCR[4] = duty2;       // CCR4 duty cycle is duty2/period
+}
+
+//***************************PWM_Period*******************************
+// Inputs:  none
+// Outputs: duty steps in the current period
+uint16_t PWM_Period(void){
+  return TIMER_A0->CCR[0];
+}
+
+//***************************PWM_Counts*******************************
+// Inputs:  normalized duty, 0 to PWM_SCALE-1
+// Outputs: compare value, duty*period/PWM_SCALE
+uint16_t PWM_Counts(uint16_t duty){
+  return ((uint32_t)duty*TIMER_A0->CCR[0])/PWM_SCALE;
+}
+
+//***************************PWM_Phase*******************************
+// direction pins changed with the duties, as bit-band aliases
+// Inputs:  phase1, phase2, bit-band words, 0 for none
+//          dead, PWM periods at 0 duty on a reversal
+// Outputs: none
+void PWM_Phase(volatile uint32_t *phase1, volatile uint32_t *phase2, uint16_t dead){
+  TIMER_A0->CCTL[0] &= ~0x0010;          // hold off the ramp
+  Phase[0] = phase1;
+  Phase[1] = phase2;
+  Sign[0] = phase1 ? *phase1 : 0;        // start from what the pins drive now
+  Sign[1] = phase2 ? *phase2 : 0;
+  DeadPeriods = dead;
+  if(ShadowPending){
+    TIMER_A0->CCTL[0] |= 0x0010;
+  }
+}
+
+//***************************PWM_Slew*******************************
+// limit how fast the staged duties are reached
+// Inputs:  accel, duty increase in PWM_SCALE units per ms
+//          decel, duty decrease toward a smaller duty or 0
+//          reverse, duty decrease on the way to a direction change
+//          0 for any rate means no limit
+// Outputs: none
+void PWM_Slew(uint16_t accel, uint16_t decel, uint16_t reverse){
+  TIMER_A0->CCTL[0] &= ~0x0010;          // hold off the ramp
+  SlewRate[SLEW_ACCEL] = accel;
+  SlewRate[SLEW_DECEL] = decel;
+  SlewRate[SLEW_REVERSE] = reverse;
+  PWM_SlewSteps();
+  if(ShadowPending){
+    TIMER_A0->CCTL[0] |= 0x0010;
+  }
+}
+
+//***************************PWM_Stage*******************************
+// stage both duty cycles and directions, reached by the CCR0 ramp
+// Inputs:  duty1, duty2, 0 to PWM_SCALE-1
+//          phase1, phase2, direction bits
+// Outputs: 0 if staged, 1 if dropped
+// The CCR0 interrupt is only enabled while the outputs are
+// moving toward the staged duties, so a steady motor costs
+// no interrupts at 20 kHz.
+uint8_t PWM_Stage(uint16_t duty1, uint16_t duty2, uint8_t phase1, uint8_t phase2){
+  int32_t counts1, counts2;
+  if(duty1 >= PWM_SCALE || duty2 >= PWM_SCALE){
+    PwmDropped++;                        // bad input
+    return 1;
+  }
+  counts1 = PWM_Counts(duty1);
+  counts2 = PWM_Counts(duty2);
+  TIMER_A0->CCTL[0] &= ~0x0010;          // hold off the ramp while staging
+  if(ShadowPending){
+    PwmCoalesced++;                      // previous duties never reached the outputs
+  }
+  Target[0] = phase1 ? -counts1 : counts1;
+  Target[1] = phase2 ? -counts2 : counts2;
+  ShadowPending = 1;
+  TIMER_A0->CCTL[0] = (TIMER_A0->CCTL[0]&~0x0001)|0x0010; // clear stale CCIFG, arm
+  return 0;
+}
+
+//***************************PWM_Halt*******************************
+// emergency stop, both outputs to 0% now, bypassing the ramp
+// Inputs:  none
+// Outputs: none
+void PWM_Halt(void){
+  TIMER_A0->CCTL[0] = 0x0080;            // disarm the ramp
+  TIMER_A0->CCR[3] = 0;
+  TIMER_A0->CCR[4] = 0;
+  Target[0] = Target[1] = 0;
+  Level[0] = Level[1] = 0;
+  Dead[0] = Dead[1] = 0;
+  ShadowPending = 0;
+}
+
+// move one channel a single period toward its target
+// Output: 1 while the channel has not reached the target
+static uint8_t PWM_Ramp(uint8_t ch){
+  int32_t target = Target[ch];
+  uint8_t sign = (target < 0);
+  uint32_t goal = ((target < 0) ? -target : target)<<8;
+  uint32_t level = Level[ch];
+  uint32_t step;
+
+  if(target != 0 && sign != Sign[ch]){   // wrong direction, down to 0 first
+    if(level == 0){
+      if(Dead[ch] < DeadPeriods){        // hold at 0 for the dead time
+        Dead[ch]++;
+        return 1;
+      }
+      Dead[ch] = 0;
+      Sign[ch] = sign;
+      if(Phase[ch]) *Phase[ch] = sign;   // single-bit write, output is low
+      PwmReversals++;
+      return 1;
+    }
+    goal = 0;
+    step = SlewStep[SLEW_REVERSE];
+  }else if(goal > level){
+    step = SlewStep[SLEW_ACCEL];
+  }else{
+    step = SlewStep[SLEW_DECEL];
+  }
+  if(step == 0 || step >= ((goal > level) ? goal - level : level - goal)){
+    level = goal;
+  }else if(goal > level){
+    level += step;
+  }else{
+    level -= step;
+  }
+  Level[ch] = level;
+  return (level != goal) || (target != 0 && sign != Sign[ch]);
+}
+
+// Timer A0 CCR0: counter at the top of the period, both outputs low
+// Both compare values change in the same period, and direction pins
+// only change with the duty at 0, through the bit-band aliases, so
+// no read-modify-write of P5->OUT races with other code using the port.
+void TA0_0_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_PWM);
+  uint8_t moving = PWM_Ramp(0);
+  moving |= PWM_Ramp(1);
+  TIMER_A0->CCR[3] = Level[0]>>8;
+  TIMER_A0->CCR[4] = Level[1]>>8;
+  if(moving){
+    TIMER_A0->CCTL[0] = 0x0090;          // acknowledge, stay armed
+    PROFILE_EXIT(PROFILE_PWM);
+    return;
+  }
+  ShadowPending = 0;
+  PwmCommits++;
+  TIMER_A0->CCTL[0] = 0x0080;            // acknowledge, disarm until the next stage
+  PROFILE_EXIT(PROFILE_PWM);
 }
 
 //***************************PWM_Duty1*******************************
-// change duty cycle of PWM output on P2.4
-// Inputs:  duty1
+// change duty cycle of PWM output on P2.6
+// Inputs:  duty1, 0 to PWM_SCALE-1
 // Outputs: none
-// period of P2.6 is 2*period*666.7ns, duty cycle is duty1/period
 void PWM_Duty1(uint16_t duty1){
-  if(duty1 >= TIMER_A0->CCR[0]) return; // bad input
-  TIMER_A0->CCR[3] = duty1;             // CCR1 duty cycle is duty1/period
+  if(duty1 >= PWM_SCALE) return;        // bad input
+  TIMER_A0->CCR[3] = PWM_Counts(duty1); // CCR3 duty cycle is duty1/PWM_SCALE
 }
 
 //***************************PWM_Duty2*******************************
-// change duty cycle of PWM output on P2.5
-// Inputs:  duty2
-// Outputs: none// period of P2.7 is 2*period*666.7ns, duty cycle is duty2/period
+// change duty cycle of PWM output on P2.7
+// Inputs:  duty2, 0 to PWM_SCALE-1
+// Outputs: none
 void PWM_Duty2(uint16_t duty2){
-  if(duty2 >= TIMER_A0->CCR[0]) return; // bad input
-  TIMER_A0->CCR[4] = duty2;             // CCR2 duty cycle is duty2/period
+  if(duty2 >= PWM_SCALE) return;        // bad input
+  TIMER_A0->CCR[4] = PWM_Counts(duty2); // CCR4 duty cycle is duty2/PWM_SCALE
 }
-
-
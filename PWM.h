@@ -0,0 +1,109 @@
+// PWM.h
+// Timer A0 PWM for the two motor drivers, P2.6 (CCR3, right
+// wheel) and P2.7 (CCR4, left wheel), center aligned in
+// up-down mode.  Duty cycles are normalized to PWM_SCALE, so
+// callers do not depend on the timer period chosen for the
+// requested frequency.
+
+#ifndef PWM_H_
+#define PWM_H_
+#include <stdint.h>
+
+#define PWM_SCALE 10000         // 100.00% duty cycle
+#define PWM_CLOCK 12000000      // SMCLK in Hz
+
+// ------------PWM_Config------------
+// Pick the clock divider and period for a PWM frequency with
+// at least the requested number of duty steps, and start
+// Timer A0 with both outputs at 0% duty cycle.  The smallest
+// divider that fits the 16-bit period is used, which gives
+// the finest duty resolution at that frequency.
+// Input: hz          PWM frequency, e.g. 20000 for 20 kHz
+//        resolution  fewest duty steps acceptable (period counts)
+// Output: 0 if configured, 1 if the timer cannot meet the request
+uint8_t PWM_Config(uint32_t hz, uint32_t resolution);
+
+// ------------PWM_Init12------------
+// Start Timer A0 with a raw period in 666.7 ns counts
+// (SMCLK/8), for the RSLK lab code.
+// Input: period        half PWM period in counts
+//        duty1, duty2  initial duty in counts, less than period
+// Output: none
+void PWM_Init12(uint16_t period, uint16_t duty1, uint16_t duty2);
+
+// ------------PWM_Period------------
+// Timer counts in half a PWM period, the number of duty steps.
+// Input: none
+// Output: TA0CCR0
+uint16_t PWM_Period(void);
+
+// ------------PWM_Counts------------
+// Convert a normalized duty cycle to timer counts.
+// Input: duty  0 to PWM_SCALE-1
+// Output: compare value for the current period
+uint16_t PWM_Counts(uint16_t duty);
+
+// ------------PWM_Phase------------
+// Attach a direction (phase) output to each channel, so that
+// PWM_Stage() changes it together with the duty.  When a
+// channel reverses, its duty is held at 0 for dead periods
+// before the new direction and duty are committed.
+// Input: phase1, phase2  bit-band alias of each direction pin,
+//                        e.g. &BITBAND_PERI(P5->OUT, 5), 0 for none
+//        dead            PWM periods at 0 duty on a reversal
+// Output: none
+void PWM_Phase(volatile uint32_t *phase1, volatile uint32_t *phase2, uint16_t dead);
+
+// ------------PWM_Slew------------
+// Limit how fast the outputs move toward staged duties, as a
+// ramp run at the top of every PWM period.  A direction change
+// first ramps down at the reverse rate, holds 0 for the dead
+// time, then ramps up at the accel rate.
+// Input: accel    duty increase in PWM_SCALE units per ms
+//        decel    duty decrease toward a smaller duty or 0
+//        reverse  duty decrease on the way to a direction change
+//        0 for any rate means no limit
+// Output: none
+void PWM_Slew(uint16_t accel, uint16_t decel, uint16_t reverse);
+
+// ------------PWM_Stage------------
+// Stage both duty cycles and both direction bits.  From the
+// top of the next PWM period (Timer A0 CCR0), where both
+// outputs are low, the outputs ramp toward them within the
+// PWM_Slew() limits, both compare values changing in the same
+// period.  No runt pulses, and direction pins only change at
+// 0 duty.  Staging again before the duties are reached
+// replaces the staged values.
+// Input: duty1, duty2    0 to PWM_SCALE-1, larger drops the update
+//        phase1, phase2  direction bit of each channel, 0 or 1
+// Output: 0 if staged, 1 if dropped
+uint8_t PWM_Stage(uint16_t duty1, uint16_t duty2, uint8_t phase1, uint8_t phase2);
+
+// ------------PWM_Halt------------
+// Emergency stop: both outputs to 0% duty cycle now, bypassing
+// the ramp, and any staged duties discarded.
+// Input: none
+// Output: none
+void PWM_Halt(void);
+
+// update statistics of PWM_Stage()
+extern volatile uint32_t PwmCommits;   // staged duties reached by the ramp
+extern uint32_t PwmCoalesced;          // replaced before they were reached
+extern uint32_t PwmDropped;            // rejected for a bad duty
+extern uint32_t PwmReversals;          // direction changes after the dead time
+
+// ------------PWM_Duty1------------
+// Change the duty cycle of the right wheel output, P2.6.
+// Takes effect immediately, not for use with PWM_Stage().
+// Input: duty1  0 to PWM_SCALE-1, larger is ignored
+// Output: none
+void PWM_Duty1(uint16_t duty1);
+
+// ------------PWM_Duty2------------
+// Change the duty cycle of the left wheel output, P2.7.
+// Takes effect immediately, not for use with PWM_Stage().
+// Input: duty2  0 to PWM_SCALE-1, larger is ignored
+// Output: none
+void PWM_Duty2(uint16_t duty2);
+
+#endif /* PWM_H_ */
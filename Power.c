@@ -0,0 +1,80 @@
+// Power.c
+// Tickless idle and power mode residency.
+
+#include <stdint.h>
+#include "msp.h"
+#include "CortexM.h"
+#include "Power.h"
+#include "Timebase.h"
+
+uint32_t PowerWakeups;
+uint32_t PowerSpans;
+static uint32_t PowerTicks;                 // ticks since reset
+static uint64_t PowerSleep;                 // bus cycles asleep since reset
+static uint32_t Tick;                       // tick period in bus cycles
+static uint16_t Span = 1;                   // ticks per SysTick period, fixed
+
+// ------------Power_Init------------
+// Select LPM0 for sleep and take the tick length and stride.
+void Power_Init(uint32_t tick, uint16_t span){
+  Tick = tick;
+  Span = span;
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;       // WFI enters LPM0, not LPM3
+}
+
+// ------------Power_Elapsed------------
+// Ticks covered by the SysTick period that just ended.
+uint16_t Power_Elapsed(void){
+  PowerTicks += Span;
+  PowerSpans++;
+  return Span;
+}
+
+// ------------Power_Idle------------
+// Sleep in LPM0 until the next interrupt.  Interrupts stay
+// masked across WFI, so the wakeup can be timed before the
+// handler runs.
+void Power_Idle(uint8_t (*work)(void)){
+  uint32_t load, before, after, cycles, slept;
+  DisableInterrupts();
+  if((SCB->ICSR&SCB_ICSR_PENDSTSET_Msk) ||  // tick already due, do not sleep
+     (work && work())){                     // or work came in since the last look
+    EnableInterrupts();
+    return;
+  }
+  load = SysTick->LOAD;
+  before = SysTick->VAL;
+  cycles = DWT->CYCCNT;
+  WaitForInterrupt();                       // wakes on a pending interrupt even while masked
+  cycles = DWT->CYCCNT - cycles;
+  after = SysTick->VAL;
+  if(SCB->ICSR&SCB_ICSR_PENDSTSET_Msk){     // SysTick reloaded while asleep
+    slept = before + (load + 1 - after);
+  }else{
+    slept = before - after;
+  }
+  PowerSleep += slept;
+  if(slept > cycles){                       // CYCCNT stopped with the core clock
+    Timebase_Sleep(slept - cycles);
+  }
+  PowerWakeups++;
+  EnableInterrupts();                       // the interrupt that woke the core runs now
+}
+
+// ------------Power_Residency------------
+// Time spent in one power mode since reset.
+uint32_t Power_Residency(uint8_t mode){
+  uint32_t sleep = PowerSleep/Tick;
+  if(mode == POWER_LPM0){
+    return sleep;
+  }
+  return PowerTicks - sleep;
+}
+
+// ------------Power_Charge------------
+// Estimated MCU charge drawn since reset.
+uint32_t Power_Charge(void){
+  uint64_t nc = (uint64_t)Power_Residency(POWER_ACTIVE)*POWER_ACTIVE_UA +
+                (uint64_t)Power_Residency(POWER_LPM0)*POWER_LPM0_UA; // uA*ms is nC
+  return nc/1000000;
+}
@@ -0,0 +1,75 @@
+// Power.h
+// Tickless idle.  SysTick runs with a fixed period of several
+// ticks, the stride that every task period and phase is a
+// multiple of (Scheduler_Stride()), so it only interrupts on
+// ticks where a task can be due, and each interrupt counts
+// all the ticks of its period.  The reload is set once and
+// never rewritten while counting, so no cycles are lost and
+// the tick count does not drift.  The main loop sleeps in
+// LPM0 between interrupts.  LPM0 is the
+// deepest mode that is safe while driving: LPM3 and below
+// stop SMCLK and MCLK, and with them the PWM, encoder and
+// reflectance timers and SysTick itself.
+// Sleep time is measured on SysTick, so the residency and
+// charge estimates cover the MCU only, not the motors.
+
+#ifndef POWER_H_
+#define POWER_H_
+#include <stdint.h>
+
+// power modes for Power_Residency()
+#define POWER_ACTIVE 0              // core running, interrupts or main loop
+#define POWER_LPM0   1              // core asleep, clocks running
+#define POWER_MODES  2
+
+// typical MSP432P401R supply current at 48 MHz, VCORE1, from flash
+#define POWER_ACTIVE_UA 4600
+#define POWER_LPM0_UA   1800
+
+#define POWER_MAX_CYCLES 0x1000000  // longest SysTick period, 24-bit reload
+
+extern uint32_t PowerWakeups;       // times Power_Idle() slept
+extern uint32_t PowerSpans;         // SysTick interrupts, one per span ticks
+
+// ------------Power_Init------------
+// Select LPM0 for sleep and take the tick length and the
+// number of ticks in each SysTick period.  Call after every
+// SysTick_Init(span*tick).  The statistics are kept.
+// Input: tick   tick period in bus cycles
+//        span   ticks per SysTick period, 1 for a plain tick,
+//               at most POWER_MAX_CYCLES/tick
+// Output: none
+void Power_Init(uint32_t tick, uint16_t span);
+
+// ------------Power_Elapsed------------
+// Ticks covered by the SysTick period that just ended.  Call
+// once, first thing in the SysTick interrupt.
+// Input: none
+// Output: ticks since the last SysTick interrupt, the span
+uint16_t Power_Elapsed(void);
+
+// ------------Power_Idle------------
+// Sleep in LPM0 until the next interrupt and add the time
+// asleep to the residency counters.  Call from the main loop
+// in place of WaitForInterrupt().  work() is checked with
+// interrupts masked, so an interrupt that left work for the
+// main loop just before the call is not slept through.
+// Input: work   returns nonzero when the main loop has work,
+//               0 for none
+// Output: none
+void Power_Idle(uint8_t (*work)(void));
+
+// ------------Power_Residency------------
+// Time spent in one power mode since reset.
+// Input: mode   POWER_ACTIVE or POWER_LPM0
+// Output: ms in that mode
+uint32_t Power_Residency(uint8_t mode);
+
+// ------------Power_Charge------------
+// Estimated MCU charge drawn since reset, from the residency
+// and the typical current of each mode.
+// Input: none
+// Output: charge in millicoulombs
+uint32_t Power_Charge(void);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,62 @@
+// Profile.c
+// Interrupt and function profiler.
+
+#include <stdint.h>
+#include "Profile.h"
+
+const uint8_t ProfileEnabled = PROFILE;  // defined either way, never an empty translation unit
+
+#if PROFILE
+#include "CortexM.h"
+
+struct ProfilePoint {
+  uint32_t count;
+  uint32_t min, max;
+  uint64_t sum;
+  uint32_t hist[PROFILE_BINS];
+};
+static struct ProfilePoint Point[PROFILE_POINTS];
+ProfileReport_t ProfileDumped[PROFILE_POINTS];
+
+// ------------Profile_Record------------
+// Add one sample to a point.
+void Profile_Record(uint8_t id, uint32_t cycles){
+  struct ProfilePoint *p = &Point[id];
+  uint32_t bin = 0;
+  uint32_t c = cycles >> 1;
+  while(c && bin < PROFILE_BINS - 1){   // floor(log2), at most 15 steps
+    c >>= 1;
+    bin++;
+  }
+  p->count++;
+  p->sum += cycles;
+  if(cycles < p->min || p->count == 1){
+    p->min = cycles;
+  }
+  if(cycles > p->max){
+    p->max = cycles;
+  }
+  p->hist[bin]++;
+}
+
+// ------------Profile_Dump------------
+// Copy every point into ProfileDumped and start over.
+void Profile_Dump(void){
+  uint8_t i, j;
+  long sr = StartCritical();
+  for(i = 0; i < PROFILE_POINTS; i++){
+    ProfileDumped[i].count = Point[i].count;
+    ProfileDumped[i].min = Point[i].count ? Point[i].min : 0;
+    ProfileDumped[i].max = Point[i].max;
+    ProfileDumped[i].mean = Point[i].count ? Point[i].sum/Point[i].count : 0;
+    for(j = 0; j < PROFILE_BINS; j++){
+      ProfileDumped[i].hist[j] = Point[i].hist[j];
+      Point[i].hist[j] = 0;
+    }
+    Point[i].count = 0;
+    Point[i].max = 0;
+    Point[i].sum = 0;
+  }
+  EndCritical(sr);
+}
+#endif
@@ -0,0 +1,75 @@
+// Profile.h
+// Interrupt and function profiler on the DWT cycle counter.
+// Each profiled point keeps count, min, max, a running sum for
+// the mean and a log2 histogram of its run time in bus cycles,
+// in static SRAM.  The SysTick entry latency, cycles from the
+// nominal tick to the first instruction of the handler, is
+// kept the same way; its max minus min is the tick jitter.
+// Build with -DPROFILE=0 and every PROFILE_ macro is empty.
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+#include <stdint.h>
+
+#ifndef PROFILE
+#define PROFILE 1
+#endif
+
+// profiled points
+#define PROFILE_SYSTICK  0      // SysTick_Handler, all tasks of a tick
+#define PROFILE_LATENCY  1      // SysTick entry latency
+#define PROFILE_CONTROL  2      // controlTask, line control or detour
+#define PROFILE_PORT4    3      // PORT4_IRQHandler, bump switches
+#define PROFILE_PWM      4      // TA0_0_IRQHandler, duty ramp
+#define PROFILE_REFLECT  5      // TA2_0_IRQHandler, reflectance capture
+#define PROFILE_ENCODER  6      // TA3_0_IRQHandler and TA3_N_IRQHandler
+#define PROFILE_BATTERY  7      // ADC14_IRQHandler
+#define PROFILE_TIMER    8      // TA1_0_IRQHandler, timer service callbacks
+#define PROFILE_POINTS   9
+
+#define PROFILE_BINS 16         // bin i counts 2^i to 2^(i+1)-1 cycles, the last one everything longer
+
+struct ProfileReport {
+  uint32_t count;               // runs
+  uint32_t min, max;            // cycles
+  uint32_t mean;                // cycles
+  uint32_t hist[PROFILE_BINS];  // log2 histogram
+};
+typedef struct ProfileReport ProfileReport_t;
+
+extern const uint8_t ProfileEnabled;    // PROFILE this image was built with, for the debugger
+
+#if PROFILE
+#include "msp.h"
+
+extern ProfileReport_t ProfileDumped[PROFILE_POINTS]; // copy from the last Profile_Dump()
+
+// start timing a point, first statement of the function
+#define PROFILE_ENTER(id)   uint32_t ProfileStart = DWT->CYCCNT
+// stop timing, before every return
+#define PROFILE_EXIT(id)    Profile_Record(id, DWT->CYCCNT - ProfileStart)
+// SysTick entry latency, first statement of SysTick_Handler
+#define PROFILE_TICK()      Profile_Record(PROFILE_LATENCY, SysTick->LOAD - SysTick->VAL)
+
+// ------------Profile_Record------------
+// Add one sample to a point.  Called by the PROFILE_ macros;
+// a point must not be recorded from two priorities.
+// Input: id      PROFILE_ point
+//        cycles  sample in bus cycles
+// Output: none
+void Profile_Record(uint8_t id, uint32_t cycles);
+
+// ------------Profile_Dump------------
+// Copy every point into ProfileDumped, with the mean worked
+// out, and start the statistics over.
+// Input: none
+// Output: none
+void Profile_Dump(void);
+
+#else
+#define PROFILE_ENTER(id)
+#define PROFILE_EXIT(id)
+#define PROFILE_TICK()
+#endif
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,135 @@
+// Recovery.c
+// Line recovery after the line is lost.  The prediction is
+// the last position plus a few frames of drift, so a line that
+// was sliding off to one side is looked for further that way.
+// Every phase is bounded in time; the engine never waits.
+
+#include <stdint.h>
+#include "Recovery.h"
+
+#define REC_LOOKAHEAD 4         // frames of drift added to the last position
+
+static int32_t Recovery_Clamp(int32_t x, int32_t limit){
+  if(x > limit) return limit;
+  if(x < -limit) return -limit;
+  return x;
+}
+
+// ------------Recovery_Init------------
+// Set the search limits and clear the statistics.
+void Recovery_Init(Recovery_t *r, int32_t base, int32_t turn, int32_t full,
+                   uint32_t extrapolateMs, uint8_t search,
+                   uint32_t legMs, uint32_t legs, uint32_t spiralMs){
+  int i;
+  r->base = base;
+  r->turn = turn;
+  r->full = full;
+  r->extrapolateMs = extrapolateMs;
+  r->search = search;
+  r->legMs = legMs;
+  r->legs = legs;
+  r->spiralMs = spiralMs;
+  r->last = 0;
+  r->drift = 0;
+  r->phase = REC_IDLE;
+  r->side = 1;
+  r->attempts = 0;
+  for(i=0; i<=REC_FAILED; i++){
+    r->found[i] = 0;
+  }
+  r->lastMs = 0;
+  r->maxMs = 0;
+  r->totalMs = 0;
+}
+
+// line back in view, close the statistics for this recovery
+static void Recovery_Found(Recovery_t *r, uint32_t now){
+  r->found[r->phase]++;
+  r->lastMs = now - r->start;
+  if(r->phase != REC_FAILED){
+    r->totalMs += r->lastMs;
+    if(r->lastMs > r->maxMs) r->maxMs = r->lastMs;
+  }
+  r->phase = REC_IDLE;
+}
+
+// line just lost, predict where it went
+static void Recovery_Lost(Recovery_t *r, uint32_t now){
+  r->attempts++;
+  r->phase = REC_EXTRAPOLATE;
+  r->start = now;
+  r->phaseStart = now;
+  r->last += REC_LOOKAHEAD*r->drift;      // predicted offset from here on
+  r->side = (r->last < 0) ? -1 : 1;
+}
+
+// next phase once the current one has timed out
+static void Recovery_Advance(Recovery_t *r, uint32_t now){
+  uint32_t elapsed = now - r->phaseStart;
+  if(r->phase == REC_EXTRAPOLATE){
+    if(elapsed >= r->extrapolateMs){
+      r->phase = REC_SEARCH;
+      r->phaseStart = now;
+      r->leg = 1;
+    }
+  }else if(r->phase == REC_SEARCH){
+    if(r->search == REC_SPIRAL){
+      if(elapsed >= r->spiralMs){
+        r->phase = REC_FAILED;
+      }
+    }else if(elapsed >= r->leg*r->legMs){  // each sweep leg longer than the last
+      if(r->leg >= r->legs){
+        r->phase = REC_FAILED;
+      }else{
+        r->leg++;
+        r->side = -r->side;
+        r->phaseStart = now;
+      }
+    }
+  }
+}
+
+// ------------Recovery_Step------------
+// Run one frame.
+uint8_t Recovery_Step(Recovery_t *r, int32_t position, uint8_t lost,
+                      uint32_t now, int32_t *left, int32_t *right){
+  int32_t diff, inner;
+
+  if(!lost){
+    if(r->phase != REC_IDLE){
+      Recovery_Found(r, now);
+      r->drift = 0;                         // old drift is from before the loss
+    }else{
+      r->drift += ((position - r->last) - r->drift) >> 1;
+    }
+    r->last = position;
+    return 0;
+  }
+  if(r->phase == REC_IDLE){
+    Recovery_Lost(r, now);
+  }
+  Recovery_Advance(r, now);
+
+  switch(r->phase){
+    case REC_EXTRAPOLATE:                   // turn harder the further off it was heading
+      diff = Recovery_Clamp((int32_t)(((int64_t)r->last*r->turn)/r->full), r->turn);
+      *left = r->base + diff;
+      *right = r->base - diff;
+      break;
+    case REC_SEARCH:
+      if(r->search == REC_SPIRAL){          // inner wheel speeds up, radius grows
+        inner = -r->turn + (int32_t)(((int64_t)(r->base + r->turn)*(now - r->phaseStart))/r->spiralMs);
+        *left = (r->side > 0) ? r->base : inner;
+        *right = (r->side > 0) ? inner : r->base;
+      }else{                                // pivot in place
+        *left = r->side*r->turn;
+        *right = -r->side*r->turn;
+      }
+      break;
+    default:                                // give up, wait where it is
+      *left = 0;
+      *right = 0;
+      break;
+  }
+  return 1;
+}
@@ -0,0 +1,79 @@
+// Recovery.h
+// Line recovery after the line is lost.  First steers back
+// along the path predicted from the last position and its
+// drift, then falls back to a bounded search (a sweep of
+// growing pivots, or an expanding spiral), and gives up with
+// the motors stopped once every phase has timed out.
+// Control returns to the tracker as soon as a sensor sees the
+// line.  Keeps recovery-time statistics per phase so search
+// strategies can be compared.  No hardware access.
+
+#ifndef RECOVERY_H_
+#define RECOVERY_H_
+#include <stdint.h>
+
+// phases, also the index into found[]
+#define REC_EXTRAPOLATE 0       // steer toward the predicted line
+#define REC_SEARCH      1       // sweep or spiral search
+#define REC_FAILED      2       // every phase timed out, motors stopped
+#define REC_IDLE        3       // tracking, not recovering
+
+// fallback search strategies
+#define REC_SWEEP  0            // pivot side to side, each leg longer
+#define REC_SPIRAL 1            // forward arc that slowly opens up
+
+struct Recovery {
+  int32_t base;                 // forward duty while recovering
+  int32_t turn;                 // largest differential duty
+  int32_t full;                 // predicted offset in microns for full turn
+  uint32_t extrapolateMs;       // time limit of the extrapolation phase
+  uint32_t legMs;               // first sweep leg, later legs grow by this
+  uint32_t legs;                // sweep legs before giving up
+  uint32_t spiralMs;            // time limit of the spiral
+  uint8_t search;               // REC_SWEEP or REC_SPIRAL
+  int32_t last;                 // last seen position, microns
+  int32_t drift;                // filtered position change per frame
+  uint8_t phase;                // REC_ phase
+  int8_t side;                  // +1 line predicted right, -1 left
+  uint32_t start;               // ms when the line was lost
+  uint32_t phaseStart;          // ms when the phase (or sweep leg) began
+  uint32_t leg;                 // current sweep leg, from 1
+  // statistics
+  uint32_t attempts;            // times the line was lost
+  uint32_t found[REC_FAILED+1]; // reacquired in each phase, found[REC_FAILED] late
+  uint32_t lastMs;              // duration of the last recovery
+  uint32_t maxMs;               // longest successful recovery
+  uint32_t totalMs;             // sum of successful recoveries
+};
+typedef struct Recovery Recovery_t;
+
+// ------------Recovery_Init------------
+// Set the search limits and clear the statistics.
+// Input: r              recovery engine
+//        base, turn     forward and largest differential duty
+//        full           predicted offset in microns that calls for full turn
+//        extrapolateMs  time limit of the extrapolation phase
+//        search         REC_SWEEP or REC_SPIRAL
+//        legMs, legs    sweep: first leg time and number of legs
+//        spiralMs       spiral: time limit
+// Output: none
+void Recovery_Init(Recovery_t *r, int32_t base, int32_t turn, int32_t full,
+                   uint32_t extrapolateMs, uint8_t search,
+                   uint32_t legMs, uint32_t legs, uint32_t spiralMs);
+
+// ------------Recovery_Step------------
+// Run one frame.  While the line is in view this only tracks
+// the position and its drift.  Once the line is lost it
+// produces the wheel duties until the line is back.
+// Input: r         recovery engine
+//        position  line position in microns, ignored when lost
+//        lost      1 if no sensor sees the line
+//        now       time in ms
+//        left      signed left duty while recovering
+//        right     signed right duty while recovering
+// Output: 1 while recovering (use *left and *right),
+//         0 while tracking (the tracker drives)
+uint8_t Recovery_Step(Recovery_t *r, int32_t position, uint8_t lost,
+                      uint32_t now, int32_t *left, int32_t *right);
+
+#endif /* RECOVERY_H_ */
@@ -54,7 +54,57 @@ policies, either expressed or implied, of the FreeBSD Project.
 
 #include <stdint.h>
 #include "msp432.h"
-#include "..\inc\Clock.h"
+#include "Reflectance.h"
+#include "Clock.h"
+#include "Profile.h"
+
+static void Capture_Init(void);
+
+//distance of each sensor from center in microns
+#define W0 (-33400)
+#define W1 (-23800)
+#define W2 (-14300)
+#define W3 (-4800)
+#define W4 4800
+#define W5 14300
+#define W6 23800
+#define W7 33400
+static const int32_t SensorWeight[8] = {W0, W1, W2, W3, W4, W5, W6, W7};
+
+// Line position and FSM input class for every 8-bit sensor
+// reading, generated by the compiler from the weights above.
+// POSITION() is the weighted average used since Lab 6: bit i
+// contributes its bit value times w[7-i], so the denominator
+// is data itself.  data==0 (line lost) has no average; its
+// position is 0 and it gets its own class, 0x6.
+#define NUMERATOR(d) (((d)&0x01)*W7 + ((d)&0x02)*W6 + ((d)&0x04)*W5 + ((d)&0x08)*W4 + \
+                      ((d)&0x10)*W3 + ((d)&0x20)*W2 + ((d)&0x40)*W1 + ((d)&0x80)*W0)
+#define POSITION(d)  ((d) ? NUMERATOR(d)/(d) : 0)
+#define INCLASS(p)   (((p) == 0) ? 0x3 :                      \
+                      ((p) < -20000) ? 0x4 :                  \
+                      ((p) > 20000) ? 0x5 :                   \
+                      ((p) > -10000 && (p) < 10000) ? 0x0 :   \
+                      ((p) > 10000 && (p) < 20000) ? 0x2 :    \
+                      ((p) < -10000 && (p) > -20000) ? 0x1 : 0x0)
+#define CLASS(d)     ((d) ? INCLASS(POSITION(d)) : 0x6)
+// CENTROID() is the plain mean of the weights of the sensors
+// over the line, symmetric about the center, for control.
+#define BIT(d,i)     (((d)>>(i))&1)
+#define WEIGHTSUM(d) (BIT(d,0)*W7 + BIT(d,1)*W6 + BIT(d,2)*W5 + BIT(d,3)*W4 + \
+                      BIT(d,4)*W3 + BIT(d,5)*W2 + BIT(d,6)*W1 + BIT(d,7)*W0)
+#define BITCOUNT(d)  (BIT(d,0) + BIT(d,1) + BIT(d,2) + BIT(d,3) + \
+                      BIT(d,4) + BIT(d,5) + BIT(d,6) + BIT(d,7))
+#define CENTROID(d)  ((d) ? WEIGHTSUM(d)/BITCOUNT(d) : REFLECTANCE_NOLINE)
+#define LUT4(F,n)    F(n), F(n+1), F(n+2), F(n+3)
+#define LUT16(F,n)   LUT4(F,n), LUT4(F,n+4), LUT4(F,n+8), LUT4(F,n+12)
+#define LUT256(F)    LUT16(F,0x00), LUT16(F,0x10), LUT16(F,0x20), LUT16(F,0x30), \
+                     LUT16(F,0x40), LUT16(F,0x50), LUT16(F,0x60), LUT16(F,0x70), \
+                     LUT16(F,0x80), LUT16(F,0x90), LUT16(F,0xA0), LUT16(F,0xB0), \
+                     LUT16(F,0xC0), LUT16(F,0xD0), LUT16(F,0xE0), LUT16(F,0xF0)
+
+static const int32_t PositionTable[256] = { LUT256(POSITION) };  // microns
+static const uint8_t ClassTable[256] = { LUT256(CLASS) };        // FSM input
+static const int32_t CentroidTable[256] = { LUT256(CENTROID) };  // microns
 
 // ------------Reflectance_Init------------
 // Initialize the GPIO pins associated with the QTR-8RC
@@ -87,6 +137,7 @@ void Reflectance_Init(void){
     P9->DIR |= 0x04;//output
     P9->OUT &= ~0x04;//turn off
 
+    Capture_Init();//timer A2 capture engine, halted
 }
 
 // ------------Reflectance_Read------------
@@ -131,50 +182,28 @@ uint8_t Reflectance_Read(uint32_t time){
 
 // Perform sensor integration
 // Input: data is 8-bit result from line sensor
-// Output: position in 0.1mm relative to center of line
+// Output: FSM input class for the line position
+//   0x0 forward, 0x1 right, 0x2 left, 0x3 centered,
+//   0x4 hard left, 0x5 hard right, 0x6 line lost
+// One load from the flash table; see CLASS() above.
 int32_t Reflectance_Position(uint8_t data){
+    return ClassTable[data];
+}
 
-    //position variable will contain distance from center
-    int32_t position;
-
-    //distance of each sensor from center in microns
-    int32_t w[8] = {-33400, -23800, -14300, -4800,
-                    4800,   14300,  23800,  33400};
-
-    int32_t numerator = 0;                  //numerator of distance equation
-    int32_t denominator = 0;                //denominator of distance equation
-    uint8_t bi = 0;                         //binary states
-
-    //loop allows for summation of the numerator and denominator
-    for(uint32_t i = 0 ; i < 8; i++)
-    {
-        bi = 0b1 << i;                      //each of the discrete binary states will be looped through via bit shifting
-        numerator += (data & bi) * w[7-i];  //summation of the product between (binary states anded with the sensor data) and the distance of each sensor
-        denominator += (data & bi);         //summation of the binary states anded with the sensor data
-    }
+// Perform sensor integration
+// Input: data is 8-bit result from line sensor
+// Output: position in microns relative to center of line,
+//         0 when no sensor sees the line
+int32_t Reflectance_Offset(uint8_t data){
+    return PositionTable[data];
+}
 
-    position = numerator/denominator;       //answer of the weighted average equation
-
-    //IF STATEMENTS TO CHANGE THE POSITION OF FSM BASED ON SENSOR DATA
-    if(position == 0)
-        return 0x3;
-    //hard left
-    if(position < -20000)
-        return 0x4;
-    //hard right
-    if(position > 20000)
-        return 0x5;
-    //forward
-    if(position > -10000 && position < 10000)
-        return 0x0;
-    //left
-    if(position > 10000 && position < 20000)
-        return 0x2;
-    //right
-    if(position < -10000 && position > -20000)
-        return 0x1;
-    else
-        return 0x0;
+// Perform sensor integration
+// Input: data is 8-bit result from line sensor
+// Output: position in microns relative to center of line,
+//         REFLECTANCE_NOLINE when no sensor sees the line
+int32_t Reflectance_Centroid(uint8_t data){
+    return CentroidTable[data];
 }
 
 
@@ -209,3 +238,307 @@ uint8_t Reflectance_End(void){
     P7->OUT = ~0xFF;//turn off all 7 IR LEDs with QTRX mask
     return P7->IN;//return read in results from LEDs
 }
+
+
+// ------------Capture engine------------
+// Timer A2 runs one-shot in up mode from SMCLK (12 MHz)
+// and sequences a read of the sensors from its interrupt.
+// CHARGE:  IR LEDs on, P7 driven high for 10 us
+// DECAY:   P7 made input, wait the requested time
+// DONE:    P7 read, IR LEDs off, frame published
+// In decay-time (grayscale) mode the DECAY phase is replaced
+// by SAMPLE, a periodic interrupt that snapshots P7 and
+// records when each channel crosses low.  The frame ends as
+// soon as all eight channels have decayed.
+// The control ISR only picks up the completed frame, so
+// no spin loop runs at interrupt level.
+#define CAPTURE_IDLE    0
+#define CAPTURE_CHARGE  1
+#define CAPTURE_DECAY   2
+#define CAPTURE_SAMPLE  3
+
+#define CAPTURE_CHARGE_US   10          // capacitor charge time
+#define CAPTURE_TICKS_PER_US 12         // SMCLK=12MHz, divide by 1
+#define CAPTURE_SLACK_US    100         // interrupt latency at the sub-frame boundaries
+
+volatile uint8_t CapturePhase = CAPTURE_IDLE;
+volatile uint8_t CaptureData;           // last completed frame
+volatile uint8_t CaptureReady = 0;      // 1 when CaptureData is new
+uint16_t CaptureDecayTicks;             // decay time in timer ticks
+
+uint8_t CaptureGray;                    // 1 for decay-time mode
+uint8_t CaptureLive;                    // channels still high
+uint16_t CaptureStep;                   // sample interval in usec
+uint16_t CaptureTime;                   // usec since release
+uint16_t CaptureTimeout;                // longest decay to wait for
+uint16_t DecayWork[8];                  // decay times being measured
+volatile uint16_t DecayTime[8];         // last completed decay times, usec
+volatile uint8_t DecayReady = 0;        // 1 when DecayTime is new
+
+// Ambient-light rejection.  A decay-time capture is split into
+// sub-frames, each with its own emitter setting:
+//   bit 0 odd emitters (P9.2) light sensors 1,3,5,7 (P7.0,2,4,6)
+//   bit 1 even emitters (P5.3) light sensors 2,4,6,8 (P7.1,3,5,7)
+// A sub-frame with emitters off measures the ambient light alone.
+#define EMIT_NONE 0
+#define EMIT_ODD  1
+#define EMIT_EVEN 2
+#define EMIT_BOTH 3
+static const uint8_t EmitFrames[3] = {1, 2, 3};           // per ambient mode
+static const uint8_t EmitSequence[3][3] = {
+  {EMIT_BOTH, 0, 0},                                      // REFLECTANCE_AMBIENT_OFF
+  {EMIT_NONE, EMIT_BOTH, 0},                              // REFLECTANCE_AMBIENT_DIFF
+  {EMIT_NONE, EMIT_ODD, EMIT_EVEN}                        // REFLECTANCE_AMBIENT_SPLIT
+};
+static const uint8_t EmitChannels[4] = {0x00, 0x55, 0xAA, 0xFF};
+
+uint8_t AmbientMode = REFLECTANCE_AMBIENT_OFF;
+uint8_t CaptureFrame;                   // sub-frame being measured
+uint16_t LitTime[8];                    // decay times with emitters on
+uint16_t DarkTime[8];                   // decay times with emitters off
+
+// arm Timer A2 to interrupt once after ticks counts
+static void Capture_Arm(uint16_t ticks){
+  TIMER_A2->CTL = 0x0204;               // SMCLK, stop, clear
+  TIMER_A2->CCR[0] = ticks - 1;         // one-shot interval
+  TIMER_A2->CCTL[0] = 0x0010;           // CCIE, compare mode
+  TIMER_A2->CTL = 0x0214;               // SMCLK, up mode, clear
+}
+
+// ------------Capture_Init------------
+// Configure Timer A2 for the capture engine, halted.
+// Called from Reflectance_Init().
+// Input: none
+// Output: none
+static void Capture_Init(void){
+  TIMER_A2->CTL = 0x0204;               // SMCLK, stop, clear
+// bit  mode
+// 9-8  10    TASSEL, SMCLK=12MHz
+// 7-6  00    ID, divide by 1
+// 5-4  00    MC, stop mode
+// 2    1     TACLR, clear
+  TIMER_A2->EX0 = 0x0000;               //    divide by 1
+  TIMER_A2->CCTL[0] = 0x0000;           // no interrupt yet
+  CapturePhase = CAPTURE_IDLE;
+  CaptureReady = 0;
+  NVIC->IP[3] = (NVIC->IP[3]&0xFFFFFF00)|0x00000020; // priority 1
+  NVIC->ISER[0] = 0x00001000;           // enable interrupt 12 in NVIC
+}
+
+// turn the IR LEDs on or off
+static void Capture_Emit(uint8_t emit){
+  if(emit&EMIT_EVEN){
+    P5->OUT |= 0x08;                    // turn on 4 even IR LEDs
+  }else{
+    P5->OUT &= ~0x08;                   // turn off 4 even IR LEDs
+  }
+  if(emit&EMIT_ODD){
+    P9->OUT |= 0x04;                    // turn on 4 odd IR LEDs
+  }else{
+    P9->OUT &= ~0x04;                   // turn off 4 odd IR LEDs
+  }
+}
+
+// set the emitters and start the charge phase
+static void Capture_Charge(uint8_t emit){
+  CapturePhase = CAPTURE_CHARGE;
+  Capture_Emit(emit);
+  P7->DIR = 0xFF;                       // make P7 bits outputs
+  P7->OUT = 0xFF;                       // charge capacitor for measurement
+  Capture_Arm(CAPTURE_CHARGE_US*CAPTURE_TICKS_PER_US);
+}
+
+// stop the timer and the emitters at the end of a capture
+static void Capture_Stop(void){
+  Capture_Emit(EMIT_NONE);
+  TIMER_A2->CTL = 0x0204;               // stop until the next capture
+  TIMER_A2->CCTL[0] = 0x0000;
+  CapturePhase = CAPTURE_IDLE;
+}
+
+uint8_t Reflectance_StartCapture(uint32_t time){
+  if(CapturePhase != CAPTURE_IDLE){
+    return 1;                           // busy
+  }
+  if(time < 1) time = 1;
+  if(time > 5000) time = 5000;          // 16-bit timer limit
+  CaptureDecayTicks = time*CAPTURE_TICKS_PER_US;
+  CaptureGray = 0;
+  Capture_Charge(EMIT_BOTH);
+  return 0;
+}
+
+uint8_t Reflectance_GetFrame(uint8_t *data){
+  if(CaptureReady == 0){
+    return 0;
+  }
+  *data = CaptureData;
+  CaptureReady = 0;
+  return 1;
+}
+
+uint8_t Reflectance_Ready(void){
+  return CaptureReady | DecayReady;
+}
+
+void Reflectance_SetAmbient(uint8_t mode){
+  if(mode > REFLECTANCE_AMBIENT_SPLIT){
+    mode = REFLECTANCE_AMBIENT_OFF;     // bad input
+  }
+  AmbientMode = mode;                   // used from the next capture on
+}
+
+uint8_t Reflectance_StartDecay(uint32_t step, uint32_t timeout){
+  uint32_t limit;
+  if(CapturePhase != CAPTURE_IDLE){
+    return 1;                           // busy
+  }
+  if(step < 2) step = 2;                // bound the interrupt rate
+  if(timeout > 5000) timeout = 5000;
+  // every sub-frame is a charge, the decay and up to one step
+  // past the timeout; together they must end before the next
+  // sense period starts the next capture
+  limit = (REFLECTANCE_FRAME_US - CAPTURE_SLACK_US)/EmitFrames[AmbientMode]
+          - CAPTURE_CHARGE_US;
+  if(timeout + step > limit) timeout = (limit > 2*step) ? limit - step : step;
+  if(timeout < step) timeout = step;
+  CaptureStep = step;
+  CaptureTimeout = timeout;
+  CaptureGray = 1;
+  CaptureFrame = 0;
+  Capture_Charge(EmitSequence[AmbientMode][0]);
+  return 0;
+}
+
+uint8_t Reflectance_GetDecay(uint16_t time[8]){
+  int i;
+  if(DecayReady == 0){
+    return 0;
+  }
+  for(i=0; i<8; i++){
+    time[i] = DecayTime[i];
+  }
+  DecayReady = 0;
+  return 1;
+}
+
+void Reflectance_Ambient(const uint16_t lit[8], const uint16_t dark[8],
+                         uint16_t timeout, uint16_t out[8]){
+  uint32_t corrected;
+  int i;
+  for(i=0; i<8; i++){
+    if(dark[i] >= timeout){
+      out[i] = lit[i];                  // no measurable ambient light
+    }else if(dark[i] <= lit[i]){
+      out[i] = timeout;                 // emitters added nothing, no reflection
+    }else{
+      corrected = ((uint32_t)lit[i]*dark[i])/(dark[i] - lit[i]);
+      out[i] = (corrected > timeout) ? timeout : corrected;
+    }
+  }
+}
+
+uint8_t Reflectance_Threshold(const uint16_t time[8], const uint16_t threshold[8]){
+  uint8_t data = 0;
+  int i;
+  for(i=0; i<8; i++){
+    if(time[i] > threshold[i]){
+      data |= 1<<i;                     // slow decay (dark)
+    }
+  }
+  return data;
+}
+
+int32_t Reflectance_DecayPosition(const uint16_t time[8]){
+  int32_t numerator = 0;
+  int32_t denominator = 0;
+  int32_t weight;
+  uint16_t white = time[0];
+  uint16_t dark = time[0];
+  int i;
+  for(i=1; i<8; i++){                   // white floor and darkest channel
+    if(time[i] < white) white = time[i];
+    if(time[i] > dark) dark = time[i];
+  }
+  if(dark - white < REFLECTANCE_CONTRAST){
+    return REFLECTANCE_NOLINE;          // uniform surface, no line in view
+  }
+  for(i=0; i<8; i++){
+    weight = time[i] - white;           // darkness above the white floor
+    numerator += weight*SensorWeight[7-i]; // at most 7*5000*33400, fits in 32 bits
+    denominator += weight;
+  }
+  return numerator/denominator;
+}
+
+// record the channels that crossed low since the last snapshot
+static void Capture_Sample(uint8_t in){
+  uint8_t fell = CaptureLive&~in;
+  int i;
+  CaptureTime += CaptureStep;
+  if(fell){
+    for(i=0; i<8; i++){
+      if(fell&(1<<i)){
+        DecayWork[i] = CaptureTime;
+      }
+    }
+    CaptureLive &= in;
+  }
+}
+
+// file the finished sub-frame, then start the next one or publish
+static void Capture_EndFrame(void){
+  uint8_t emit = EmitSequence[AmbientMode][CaptureFrame];
+  uint8_t lit = EmitChannels[emit];
+  uint16_t time;
+  int i;
+  for(i=0; i<8; i++){
+    time = (CaptureLive&(1<<i)) ? CaptureTimeout : DecayWork[i];
+    if(emit == EMIT_NONE){
+      DarkTime[i] = time;
+    }else if(lit&(1<<i)){
+      LitTime[i] = time;                // only the channels this bank lights
+    }
+  }
+  CaptureFrame++;
+  if(CaptureFrame < EmitFrames[AmbientMode]){
+    Capture_Charge(EmitSequence[AmbientMode][CaptureFrame]);
+    return;
+  }
+  Capture_Stop();
+  if(AmbientMode != REFLECTANCE_AMBIENT_OFF){
+    Reflectance_Ambient(LitTime, DarkTime, CaptureTimeout, LitTime); // per channel, safe in place
+  }
+  for(i=0; i<8; i++){
+    DecayTime[i] = LitTime[i];
+  }
+  DecayReady = 1;
+}
+
+// Timer A2 CCR0 interrupt advances the capture phase
+void TA2_0_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_REFLECT);
+  TIMER_A2->CCTL[0] &= ~0x0001;         // acknowledge CCIFG
+  if(CapturePhase == CAPTURE_CHARGE){
+    P7->DIR = 0x00;                     // release, capacitors decay
+    if(CaptureGray){
+      CaptureLive = 0xFF;
+      CaptureTime = 0;
+      CapturePhase = CAPTURE_SAMPLE;
+      Capture_Arm(CaptureStep*CAPTURE_TICKS_PER_US); // periodic in up mode
+    }else{
+      CapturePhase = CAPTURE_DECAY;
+      Capture_Arm(CaptureDecayTicks);
+    }
+  }else if(CapturePhase == CAPTURE_SAMPLE){
+    Capture_Sample(P7->IN);
+    if((CaptureLive == 0)||(CaptureTime >= CaptureTimeout)){
+      Capture_EndFrame();               // ended early or timed out
+    }
+  }else if(CapturePhase == CAPTURE_DECAY){
+    CaptureData = P7->IN;               // 1 means slow decay (dark)
+    Capture_Stop();
+    CaptureReady = 1;
+  }
+  PROFILE_EXIT(PROFILE_REFLECT);
+}
@@ -0,0 +1,172 @@
+// Reflectance.h
+// Provide functions to take measurements using the kit's built-in
+// QTRX reflectance sensor array.  Pololu part number 3672.
+// Daniel and Jonathan Valvano
+// July 11, 2019
+
+#ifndef REFLECTANCE_H_
+#define REFLECTANCE_H_
+#include <stdint.h>
+
+// ------------Reflectance_Init------------
+// Initialize the GPIO pins associated with the QTR-8RC
+// reflectance sensor.  Infrared illumination LEDs are
+// initially off.  Timer A2 is configured, but halted,
+// for the interrupt-driven capture engine.
+// Input: none
+// Output: none
+void Reflectance_Init(void);
+
+// ------------Reflectance_Read------------
+// Read the eight sensors, busy-waiting for the whole
+// measurement.  Not for use inside an ISR.
+// Input: time to wait in usec
+// Output: sensor readings
+// Assumes: Reflectance_Init() has been called
+uint8_t Reflectance_Read(uint32_t time);
+
+// Perform sensor integration
+// Input: data is 8-bit result from line sensor
+// Output: FSM input class for the line position
+//   0x0 forward, 0x1 right, 0x2 left, 0x3 centered,
+//   0x4 hard left, 0x5 hard right, 0x6 line lost
+int32_t Reflectance_Position(uint8_t data);
+
+// Perform sensor integration
+// Input: data is 8-bit result from line sensor
+// Output: position in microns relative to center of line,
+//         0 when no sensor sees the line
+int32_t Reflectance_Offset(uint8_t data);
+
+// Perform sensor integration, unweighted: the mean position
+// of the sensors that see the line.  Reflectance_Offset()
+// keeps the Lab 6 weighting by bit value, which leans toward
+// the left sensors (0x18 gives -1600 um); use this one as the
+// error of a controller.
+// Input: data is 8-bit result from line sensor
+// Output: position in microns relative to center of line,
+//         REFLECTANCE_NOLINE when no sensor sees the line
+int32_t Reflectance_Centroid(uint8_t data);
+
+// ------------Reflectance_Start------------
+// Begin the process of reading the eight sensors
+// Input: none
+// Output: none
+// Assumes: Reflectance_Init() has been called
+void Reflectance_Start(void);
+
+// ------------Reflectance_End------------
+// Finish reading the eight sensors
+// Input: none
+// Output: sensor readings
+// Assumes: Reflectance_Start() was called 1 ms ago
+uint8_t Reflectance_End(void);
+
+// ------------Reflectance_StartCapture------------
+// Begin a non-blocking read of the eight sensors.  The
+// charge, release and read phases are sequenced by the
+// Timer A2 interrupt, so this returns immediately.
+// Input: time to wait after release in usec (1 to 5000)
+// Output: 0 if started, 1 if a capture is already running
+// Assumes: Reflectance_Init() has been called
+uint8_t Reflectance_StartCapture(uint32_t time);
+
+// ------------Reflectance_GetFrame------------
+// Pick up the most recent completed capture.  Each frame
+// is returned once.
+// Input: pointer to storage for the sensor readings
+// Output: 1 if a new frame was stored in *data, 0 if not
+uint8_t Reflectance_GetFrame(uint8_t *data);
+
+// ------------Reflectance_Ready------------
+// Check for a completed capture of either kind without
+// taking it; safe with interrupts masked.
+// Input: none
+// Output: nonzero if a frame is waiting to be picked up
+uint8_t Reflectance_Ready(void);
+
+// returned by Reflectance_DecayPosition() when no line is in view
+#define REFLECTANCE_NOLINE   ((int32_t)0x80000000)
+// minimum spread in usec between white floor and darkest channel
+#define REFLECTANCE_CONTRAST 200
+
+// ------------Reflectance_StartDecay------------
+// Begin a non-blocking decay-time (grayscale) read of the
+// eight sensors.  After the charge phase, Timer A2 samples
+// P7 every step usec and records when each channel crosses
+// low.  The frame ends as soon as every channel has decayed,
+// or after timeout usec.  The ambient mode selected by
+// Reflectance_SetAmbient() adds emitters-off sub-frames, and
+// the timeout is cut so that all of them together fit in
+// REFLECTANCE_FRAME_US: about 4900 usec each in DIFF mode and
+// 3300 usec in SPLIT mode.
+// Every sample is a Timer A2 interrupt at priority 1, above
+// SysTick, of about 70 bus cycles (1.5 usec at 48 MHz, counted
+// from the sample path; PROFILE_REFLECT measures it).  While a
+// capture runs that is about 15% of the CPU at a 10 usec step
+// and 6% at 25 usec, and DIFF and SPLIT captures run for most
+// of each sense period.  CalProfile.step holds the step used.
+// Input: step     sample interval in usec (2 to timeout)
+//        timeout  longest decay time to wait for in usec (up to 5000)
+// Output: 0 if started, 1 if a capture is already running
+// Assumes: Reflectance_Init() has been called
+uint8_t Reflectance_StartDecay(uint32_t step, uint32_t timeout);
+
+#define REFLECTANCE_FRAME_US 10000    // sense period, a whole capture fits in it
+
+// ------------Reflectance_GetDecay------------
+// Pick up the most recent completed decay-time frame.
+// time[i] is the decay time of sensor i+1 (P7.i) in usec,
+// quantized to the sample step; channels that never
+// decayed read as the timeout.  Darker surface, longer time.
+// Input: array of 8 for the decay times
+// Output: 1 if a new frame was stored in time[], 0 if not
+uint8_t Reflectance_GetDecay(uint16_t time[8]);
+
+// ------------Reflectance_DecayPosition------------
+// Intensity-weighted line position from a decay-time frame.
+// Each channel is weighted by its decay time above the
+// whitest channel, giving sub-sensor resolution.
+// Input: decay times from Reflectance_GetDecay()
+// Output: position in microns, same sign as Reflectance_Position,
+//         or REFLECTANCE_NOLINE if the frame has no contrast
+int32_t Reflectance_DecayPosition(const uint16_t time[8]);
+
+// ambient-light rejection modes for decay-time captures
+#define REFLECTANCE_AMBIENT_OFF   0   // one frame, all emitters on
+#define REFLECTANCE_AMBIENT_DIFF  1   // emitters-off frame, then all on
+#define REFLECTANCE_AMBIENT_SPLIT 2   // emitters off, then odd bank, then even bank
+
+// ------------Reflectance_SetAmbient------------
+// Select the ambient-light rejection mode used by
+// Reflectance_StartDecay().  In the DIFF and SPLIT modes the
+// capture takes one frame with the emitters off and combines
+// it with the lit frames, so each mode costs one more decay
+// time per frame.  SPLIT lights only one bank at a time to
+// reduce crosstalk between neighboring channels.
+// Input: REFLECTANCE_AMBIENT_OFF, _DIFF or _SPLIT
+// Output: none
+void Reflectance_SetAmbient(uint8_t mode);
+
+// ------------Reflectance_Ambient------------
+// Remove the ambient contribution from a lit decay-time
+// frame.  Photocurrents add, and decay time goes as one over
+// photocurrent, so the emitter-only time is
+//   lit*dark/(dark - lit)
+// Input: lit     decay times with emitters on, usec
+//        dark    decay times with emitters off, usec
+//        timeout capture timeout, upper limit of every time
+//        out     corrected decay times, usec, may be lit
+// Output: none
+void Reflectance_Ambient(const uint16_t lit[8], const uint16_t dark[8],
+                         uint16_t timeout, uint16_t out[8]);
+
+// ------------Reflectance_Threshold------------
+// Reduce a decay-time frame to the 8-bit reading used by
+// Reflectance_Position().
+// Input: time       decay times, usec
+//        threshold  per-channel decay time separating white and black
+// Output: bit i set if sensor i+1 decayed slower than its threshold
+uint8_t Reflectance_Threshold(const uint16_t time[8], const uint16_t threshold[8]);
+
+#endif /* REFLECTANCE_H_ */
@@ -0,0 +1,112 @@
+// Scheduler.c
+// Static tick scheduler, run from the SysTick interrupt.
+
+#include <stdint.h>
+#include "msp.h"
+#include "Scheduler.h"
+#include "Timebase.h"
+
+TaskStat_t SchedStat[SCHED_MAX_TASKS];
+uint32_t SchedTickOverruns;
+uint32_t SchedTickMax;
+
+static Task_t *Table;
+static uint8_t Count;
+static uint8_t Order[SCHED_MAX_TASKS];      // table indices, highest priority first
+static uint16_t Left[SCHED_MAX_TASKS];      // ticks until each task is due
+static uint32_t Budget[SCHED_MAX_TASKS];    // budgets in bus cycles
+static uint32_t Tick;                       // tick period in bus cycles
+
+// ------------Scheduler_Init------------
+// Take the task table, order it by priority and clear the
+// statistics.
+void Scheduler_Init(Task_t *table, uint8_t count, uint32_t tick){
+  uint8_t i, j, k;
+  if(count > SCHED_MAX_TASKS){
+    count = SCHED_MAX_TASKS;
+  }
+  Table = table;
+  Count = count;
+  Tick = tick;
+  for(i = 0; i < count; i++){
+    j = i;                              // insertion sort, stable for equal priorities
+    while(j > 0 && table[Order[j-1]].priority > table[i].priority){
+      Order[j] = Order[j-1];
+      j--;
+    }
+    Order[j] = i;
+    Left[i] = table[i].phase + 1;       // the first tick after Init counts as tick 0
+    Budget[i] = Timebase_UsToCycles(table[i].budget);
+    SchedStat[i].runs = 0;
+    SchedStat[i].overruns = 0;
+    SchedStat[i].maxCycles = 0;
+  }
+  for(k = count; k < SCHED_MAX_TASKS; k++){
+    SchedStat[k].runs = 0;
+    SchedStat[k].overruns = 0;
+    SchedStat[k].maxCycles = 0;
+  }
+  SchedTickOverruns = 0;
+  SchedTickMax = 0;
+}
+
+// ------------Scheduler_Tick------------
+// Run the tasks due on this tick.
+void Scheduler_Tick(uint16_t elapsed){
+  uint8_t i, n;
+  uint32_t tickStart = Timebase_Cycles();
+  uint32_t start, cycles;
+  for(n = 0; n < Count; n++){
+    i = Order[n];
+    if(Left[i] > elapsed){
+      Left[i] -= elapsed;
+      continue;
+    }
+    Left[i] = Table[i].period;
+    start = Timebase_Cycles();
+    Table[i].run();
+    cycles = Timebase_Elapsed(start);
+    SchedStat[i].runs++;
+    if(cycles > SchedStat[i].maxCycles){
+      SchedStat[i].maxCycles = cycles;
+    }
+    if(cycles > Budget[i]){
+      SchedStat[i].overruns++;
+    }
+  }
+  cycles = Timebase_Elapsed(tickStart);
+  if(cycles > SchedTickMax){
+    SchedTickMax = cycles;
+  }
+  if(cycles >= elapsed*Tick){           // the next SysTick period is already late
+    SchedTickOverruns++;
+  }
+}
+
+// greatest common divisor, gcd(a, 0) is a
+static uint16_t Scheduler_Gcd(uint16_t a, uint16_t b){
+  uint16_t t;
+  while(b){
+    t = a%b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// ------------Scheduler_Stride------------
+// Largest number of ticks every task period and phase is a multiple of.
+uint16_t Scheduler_Stride(uint16_t most){
+  uint8_t i;
+  uint16_t g = 0, s;
+  for(i = 0; i < Count; i++){
+    g = Scheduler_Gcd(Table[i].period, g);
+    g = Scheduler_Gcd(Table[i].phase, g); // phase 0 changes nothing
+  }
+  if(g == 0){
+    return 1;                           // no tasks
+  }
+  for(s = (g < most) ? g : most; s > 1 && g%s; s--){
+  }                                     // largest divisor the caller can time
+  return s;
+}
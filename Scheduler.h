@@ -0,0 +1,61 @@
+// Scheduler.h
+// Static tick scheduler.  The task table is a const array
+// built at compile time; each task runs every period ticks,
+// starting phase ticks after Scheduler_Init.  Tasks due on the
+// same tick run in priority order.  The tick path only counts
+// down, no divide or modulo, and times every task with the
+// DWT cycle counter against its worst-case budget.
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS     8           // size of the run-time state arrays
+
+struct Task {
+  void (*run)(void);            // task body, runs in the tick interrupt
+  uint16_t period;              // ticks between runs, 1 or more
+  uint16_t phase;               // ticks before the first run, less than period
+  uint8_t priority;             // 0 runs first within a tick
+  uint16_t budget;              // worst-case run time in usec
+};
+typedef const struct Task Task_t;
+
+struct TaskStat {
+  uint32_t runs;                // times the task ran
+  uint32_t overruns;            // runs longer than the budget
+  uint32_t maxCycles;           // longest run in bus cycles
+};
+typedef struct TaskStat TaskStat_t;
+
+extern TaskStat_t SchedStat[SCHED_MAX_TASKS]; // per task, table order
+extern uint32_t SchedTickOverruns;  // ticks whose tasks ran past the next tick
+extern uint32_t SchedTickMax;       // longest tick in bus cycles
+
+// ------------Scheduler_Init------------
+// Take the task table, order it by priority and clear the
+// statistics.  Run times come from the timebase, Timebase.h,
+// and budgets are converted at its current bus clock.
+// Input: table   const task table
+//        count   number of tasks, at most SCHED_MAX_TASKS
+//        tick    tick period in bus cycles, the SysTick period
+// Output: none
+void Scheduler_Init(Task_t *table, uint8_t count, uint32_t tick);
+
+// ------------Scheduler_Tick------------
+// Run the tasks due on this tick.  Call from the SysTick
+// interrupt, once per tick or, with a SysTick period of
+// several ticks, once per period.
+// Input: elapsed  ticks since the last call, a multiple of Scheduler_Stride()
+// Output: none
+void Scheduler_Tick(uint16_t elapsed);
+
+// ------------Scheduler_Stride------------
+// Largest number of ticks that every task period and phase is
+// a multiple of.  A SysTick period of that many ticks still
+// lands on every tick a task is due, for tickless idle.
+// Input: most  longest stride the caller can time
+// Output: ticks per SysTick period, 1 or more
+uint16_t Scheduler_Stride(uint16_t most);
+
+#endif /* SCHEDULER_H_ */
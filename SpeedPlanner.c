@@ -0,0 +1,71 @@
+// SpeedPlanner.c
+// Adaptive forward speed for line tracking.  The base duty
+// ramps up while the line stays centered and steady, and is
+// cut back early once the position starts to drift.
+// Error is a fast low-pass of |position| plus twice the
+// frame-to-frame drift, so a line that starts to move off
+// center brakes the robot before the offset itself is large.
+
+#include <stdint.h>
+#include "SpeedPlanner.h"
+
+#define STEADY_BAND 4800        // inside the two center sensors, microns
+
+static int32_t Planner_Abs(int32_t x){
+  return (x < 0) ? -x : x;
+}
+
+// ------------Planner_Init------------
+// Set the limits and start at minBase.
+void Planner_Init(Planner_t *p, int32_t minBase, int32_t maxBase,
+                  int32_t accel, int32_t decel, int32_t curveBand,
+                  int32_t straightSteps){
+  p->minBase = minBase;
+  p->maxBase = maxBase;
+  p->accel = accel;
+  p->decel = decel;
+  p->curveBand = curveBand;
+  p->straightSteps = straightSteps;
+  p->slope = ((maxBase - minBase) << 16)/curveBand;  // once, not per step
+  p->error = 0;
+  p->lastPosition = 0;
+  p->steady = 0;
+  p->base = minBase;
+}
+
+// ------------Planner_Step------------
+// Update the base duty from the newest line position.
+int32_t Planner_Step(Planner_t *p, int32_t position, uint8_t lost){
+  int32_t sample, target;
+
+  if(lost){
+    sample = p->curveBand;                  // no line, plan for the worst
+    p->lastPosition = 0;
+  }else{
+    sample = Planner_Abs(position) + 2*Planner_Abs(position - p->lastPosition);
+    p->lastPosition = position;
+  }
+  p->error += (sample - p->error) >> 2;     // fast low-pass
+  if(p->error > p->curveBand) p->error = p->curveBand;
+
+  if(p->error < STEADY_BAND){
+    if(p->steady < p->straightSteps) p->steady++;
+  }else{
+    p->steady = 0;
+  }
+
+  // speed falls linearly with error; maxBase only on a proven straight
+  target = p->maxBase - (int32_t)(((int64_t)p->error*p->slope) >> 16);
+  if((p->steady < p->straightSteps) && (target > (p->minBase + p->maxBase)/2)){
+    target = (p->minBase + p->maxBase)/2;
+  }
+
+  if(target > p->base + p->accel){
+    p->base += p->accel;
+  }else if(target < p->base - p->decel){
+    p->base -= p->decel;
+  }else{
+    p->base = target;
+  }
+  return p->base;
+}
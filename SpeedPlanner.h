@@ -0,0 +1,49 @@
+// SpeedPlanner.h
+// Adaptive forward speed for line tracking.  The base duty
+// ramps up while the line stays centered and steady, and is
+// cut back early once the position starts to drift, within
+// separate acceleration and deceleration limits.
+// Constant time per step (no loops, no divide), no hardware
+// access.
+
+#ifndef SPEEDPLANNER_H_
+#define SPEEDPLANNER_H_
+#include <stdint.h>
+
+struct Planner {
+  int32_t minBase;              // base duty in the tightest curve
+  int32_t maxBase;              // base duty on a long straight
+  int32_t accel;                // largest increase per step, duty
+  int32_t decel;                // largest decrease per step, duty
+  int32_t curveBand;            // error in microns that calls for minBase
+  int32_t straightSteps;        // steady steps before reaching maxBase
+  int32_t slope;                // Q16 duty per micron of error
+  int32_t error;                // filtered |position| + drift, microns
+  int32_t lastPosition;         // position on the previous step
+  int32_t steady;               // consecutive steady steps
+  int32_t base;                 // current base duty
+};
+typedef struct Planner Planner_t;
+
+// ------------Planner_Init------------
+// Set the limits and start at minBase.
+// Input: p              planner
+//        minBase        base duty in the tightest curve
+//        maxBase        base duty on a long straight
+//        accel, decel   largest change per step, duty
+//        curveBand      error in microns that calls for minBase (> 0)
+//        straightSteps  steady steps before maxBase is allowed
+// Output: none
+void Planner_Init(Planner_t *p, int32_t minBase, int32_t maxBase,
+                  int32_t accel, int32_t decel, int32_t curveBand,
+                  int32_t straightSteps);
+
+// ------------Planner_Step------------
+// Update the base duty from the newest line position.
+// Input: p         planner
+//        position  line position in microns, ignored when lost
+//        lost      1 if the line is not in view
+// Output: base duty to drive both wheels around
+int32_t Planner_Step(Planner_t *p, int32_t position, uint8_t lost);
+
+#endif /* SPEEDPLANNER_H_ */
@@ -0,0 +1,114 @@
+// Timebase.c
+// DWT cycle counter delays and timestamps.
+
+#include <stdint.h>
+#include "msp.h"
+#include "Clock.h"
+#include "CortexM.h"
+#include "Timebase.h"
+
+#define TIMEBASE_CHUNK 0x40000000           // longest single busy-wait, cycles
+
+static uint32_t Hz = 3000000;               // bus clock, DCO default at reset
+static uint32_t CyclesPerUs = 3<<16;        // Q16 cycles per usec
+static uint32_t Offset;                     // cycles slept, added to CYCCNT
+static uint32_t Last;                       // last Timebase_Cycles() seen by Timebase_Now()
+static uint32_t High;                       // wraps seen by Timebase_Now()
+static uint64_t Origin;                     // Timebase_Now() at the last clock change
+static uint64_t OriginUs;                   // Timebase_Micros() at the last clock change
+
+// ------------Timebase_Init------------
+// Start the DWT cycle counter and take the current bus clock.
+void Timebase_Init(void){
+  if(DWT->CTRL&DWT_CTRL_CYCCNTENA_Msk){     // running, close the interval at the old clock
+    OriginUs = Timebase_Micros();
+    Origin = Timebase_Now();
+  }else{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+  Hz = Clock_GetFreq();
+  CyclesPerUs = ((uint64_t)Hz<<16)/1000000;
+}
+
+// ------------Timebase_Cycles------------
+// 32-bit timestamp.
+uint32_t Timebase_Cycles(void){
+  return DWT->CYCCNT + Offset;
+}
+
+// ------------Timebase_Elapsed------------
+// Cycles since a Timebase_Cycles() stamp.
+uint32_t Timebase_Elapsed(uint32_t start){
+  return Timebase_Cycles() - start;
+}
+
+// ------------Timebase_Now------------
+// 64-bit monotonic timestamp.
+uint64_t Timebase_Now(void){
+  uint32_t now;
+  uint64_t stamp;
+  long sr = StartCritical();
+  now = Timebase_Cycles();
+  if(now < Last){                           // counter wrapped since the last call
+    High++;
+  }
+  Last = now;
+  stamp = ((uint64_t)High<<32)|now;
+  EndCritical(sr);
+  return stamp;
+}
+
+// ------------Timebase_Micros------------
+// 64-bit monotonic time in usec.
+uint64_t Timebase_Micros(void){
+  uint64_t cycles = Timebase_Now() - Origin;
+  return OriginUs + (cycles/Hz)*1000000 + ((cycles%Hz)*1000000)/Hz;
+}
+
+// ------------Timebase_UsToCycles------------
+// Bus cycles in a number of microseconds.
+uint32_t Timebase_UsToCycles(uint32_t us){
+  return ((uint64_t)us*CyclesPerUs)>>16;
+}
+
+// ------------Timebase_MsToCycles------------
+// Bus cycles in a number of milliseconds.
+uint32_t Timebase_MsToCycles(uint32_t ms){
+  return ((uint64_t)ms*Hz)/1000;
+}
+
+// ------------Timebase_DelayCycles------------
+// Busy-wait a number of bus cycles.
+void Timebase_DelayCycles(uint32_t n){
+  uint32_t start = DWT->CYCCNT;             // no sleep inside, the raw counter is enough
+  while((DWT->CYCCNT - start) < n){
+  }
+}
+
+// ------------Timebase_DelayUs------------
+// Busy-wait a number of microseconds.
+void Timebase_DelayUs(uint32_t n){
+  uint64_t cycles = ((uint64_t)n*CyclesPerUs)>>16; // 64 bits, n may exceed 2^32 cycles
+  while(cycles > TIMEBASE_CHUNK){
+    Timebase_DelayCycles(TIMEBASE_CHUNK);
+    cycles -= TIMEBASE_CHUNK;
+  }
+  Timebase_DelayCycles((uint32_t)cycles);
+}
+
+// ------------Timebase_DelayMs------------
+// Busy-wait a number of milliseconds.
+void Timebase_DelayMs(uint32_t n){
+  while(n){
+    Timebase_DelayUs(1000);
+    n--;
+  }
+}
+
+// ------------Timebase_Sleep------------
+// Account for cycles the counter missed while the core slept.
+void Timebase_Sleep(uint32_t cycles){
+  Offset += cycles;
+}
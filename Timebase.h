@@ -0,0 +1,88 @@
+// Timebase.h
+// Cycle-accurate delays and timestamps on the Cortex-M4 DWT
+// cycle counter.  Delays convert microseconds to cycles at
+// the clock rate reported by Clock_GetFreq(), so they hold at
+// any bus clock; call Timebase_Init() again after changing it.
+// CYCCNT stops while the core sleeps.  Power_Idle() hands the
+// cycles it slept to Timebase_Sleep(), so timestamps include
+// the time asleep.
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+#include <stdint.h>
+
+// ------------Timebase_Init------------
+// Start the DWT cycle counter and take the current bus
+// clock.  Called by Clock_Init48MHz(); call it after any
+// other clock change.  Timestamps stay monotonic across calls.
+// Input: none
+// Output: none
+void Timebase_Init(void);
+
+// ------------Timebase_Cycles------------
+// 32-bit timestamp, wraps every 2^32 cycles (89 s at 48 MHz).
+// Differences of two stamps give elapsed cycles.
+// Input: none
+// Output: bus cycles
+uint32_t Timebase_Cycles(void);
+
+// ------------Timebase_Elapsed------------
+// Cycles since a Timebase_Cycles() stamp.
+// Input: start   earlier Timebase_Cycles() value
+// Output: bus cycles since start, under 2^32
+uint32_t Timebase_Elapsed(uint32_t start);
+
+// ------------Timebase_Now------------
+// 64-bit monotonic timestamp.  Must be called at least once
+// per 2^32 cycles to see every wrap of the counter.
+// Input: none
+// Output: bus cycles since the first Timebase_Init()
+uint64_t Timebase_Now(void);
+
+// ------------Timebase_Micros------------
+// 64-bit monotonic time, correct across clock changes.
+// Input: none
+// Output: usec since the first Timebase_Init()
+uint64_t Timebase_Micros(void);
+
+// ------------Timebase_UsToCycles------------
+// Bus cycles in a number of microseconds at the clock taken by
+// the last Timebase_Init(), for budgets and timeouts measured
+// against Timebase_Cycles().
+// Input: us  usec, under 2^32 cycles (89 s at 48 MHz)
+// Output: bus cycles
+uint32_t Timebase_UsToCycles(uint32_t us);
+
+// ------------Timebase_MsToCycles------------
+// Bus cycles in a number of milliseconds, as above.
+// Input: ms  msec, under 2^32 cycles
+// Output: bus cycles
+uint32_t Timebase_MsToCycles(uint32_t ms);
+
+// ------------Timebase_DelayCycles------------
+// Busy-wait a number of bus cycles.
+// Input: n   cycles to wait, under 2^31
+// Output: none
+// Assumes: Timebase_Init() has been called
+void Timebase_DelayCycles(uint32_t n);
+
+// ------------Timebase_DelayUs------------
+// Busy-wait a number of microseconds.
+// Input: n   usec to wait
+// Output: none
+void Timebase_DelayUs(uint32_t n);
+
+// ------------Timebase_DelayMs------------
+// Busy-wait a number of milliseconds.
+// Input: n   msec to wait
+// Output: none
+void Timebase_DelayMs(uint32_t n);
+
+// ------------Timebase_Sleep------------
+// Account for cycles the counter missed while the core slept.
+// Call with interrupts disabled.
+// Input: cycles  bus cycles asleep that CYCCNT did not count
+// Output: none
+void Timebase_Sleep(uint32_t cycles);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,198 @@
+// TimerService.c
+// Timer A1 one-shot and periodic callbacks.
+// TA1.CCR0 (interrupt 10) fires for the earliest event,
+// the TA1 overflow (interrupt 11) counts the upper 16 bits.
+
+#include <stdint.h>
+#include "msp.h"
+#include "CortexM.h"
+#include "TimerService.h"
+#include "Profile.h"
+
+#define TIMER_SOON 3                    // usec; closer than this is run at once
+
+struct TimerSlot {
+  uint32_t due;                         // usec on the TimerService_Now() clock
+  uint32_t period;                      // usec, 0 for one-shot
+  void (*task)(void);
+};
+static struct TimerSlot Slot[TIMER_SLOTS];
+static uint8_t Order[TIMER_SLOTS];      // pending slots, earliest first
+static uint8_t Pending;                 // entries in Order
+static uint8_t Free;                    // bit i set when Slot[i] is free
+static volatile uint16_t Overflows;     // upper 16 bits of the clock
+
+uint32_t TimerFired;
+uint32_t TimerSkipped;
+uint32_t TimerLateMax;
+uint32_t TimerFull;
+
+// ------------TimerService_Init------------
+// Start Timer A1 as the microsecond clock with no events.
+void TimerService_Init(uint32_t priority){
+  TIMER_A1->CTL = 0x0284;               // SMCLK, divide by 4, stop, clear
+  TIMER_A1->EX0 = 0x0002;               //    divide by 3, 1 MHz
+  TIMER_A1->CCTL[0] = 0x0000;           // compare, no interrupt until an event is pending
+  Pending = 0;
+  Free = (1<<TIMER_SLOTS) - 1;
+  Overflows = 0;
+// bits31-29 interrupt 11, bits23-21 interrupt 10
+  NVIC->IP[2] = (NVIC->IP[2]&0x0000FFFF)|(priority<<29)|(priority<<21);
+  NVIC->ISER[0] = 0x00000C00;           // enable interrupts 10 and 11 in NVIC
+  TIMER_A1->CTL = 0x02A6;               // SMCLK/4/3, continuous mode, clear, TAIE
+}
+
+// ------------TimerService_Now------------
+// Microsecond clock.
+uint32_t TimerService_Now(void){
+  uint16_t high, low;
+  long sr = StartCritical();
+  high = Overflows;
+  low = TIMER_A1->R;
+  if((TIMER_A1->CTL&0x0001) && low < 0x8000){ // wrapped, overflow not counted yet
+    high++;
+  }
+  EndCritical(sr);
+  return ((uint32_t)high<<16)|low;
+}
+
+// Program CCR0 for the earliest event.  Events more than one
+// timer wrap away are armed later from the overflow interrupt.
+// Call with interrupts disabled.
+static void TimerService_Arm(void){
+  int32_t wait;
+  if(Pending == 0){
+    TIMER_A1->CCTL[0] = 0x0000;
+    return;
+  }
+  wait = (int32_t)(Slot[Order[0]].due - TimerService_Now());
+  if(wait < TIMER_SOON){
+    TIMER_A1->CCTL[0] = 0x0011;         // CCIE and CCIFG, interrupt now
+  }else if(wait < 0x10000){
+    TIMER_A1->CCR[0] = (uint16_t)Slot[Order[0]].due;
+    TIMER_A1->CCTL[0] = 0x0010;         // CCIE, clear CCIFG
+  }else{
+    TIMER_A1->CCTL[0] = 0x0000;
+  }
+}
+
+// Insert a slot into Order by due time, after events due at
+// the same time.  Call with interrupts disabled.
+static void TimerService_Insert(uint8_t s, uint32_t now){
+  uint8_t j = Pending;
+  int32_t wait = (int32_t)(Slot[s].due - now);
+  while(j > 0 && (int32_t)(Slot[Order[j-1]].due - now) > wait){
+    Order[j] = Order[j-1];
+    j--;
+  }
+  Order[j] = s;
+  Pending++;
+}
+
+// claim a slot and queue it
+static uint8_t TimerService_Add(uint32_t due, uint32_t period, void (*task)(void)){
+  uint8_t s;
+  long sr = StartCritical();
+  if(Free == 0){
+    TimerFull++;
+    EndCritical(sr);
+    return TIMER_NONE;
+  }
+  for(s = 0; !(Free&(1<<s)); s++){
+  }
+  Free &= ~(1<<s);
+  Slot[s].due = due;
+  Slot[s].period = period;
+  Slot[s].task = task;
+  TimerService_Insert(s, TimerService_Now());
+  TimerService_Arm();
+  EndCritical(sr);
+  return s;
+}
+
+// ------------TimerService_At------------
+// Run a task once at a given time.
+uint8_t TimerService_At(uint32_t time, void (*task)(void)){
+  return TimerService_Add(time, 0, task);
+}
+
+// ------------TimerService_After------------
+// Run a task once, delay usec from now.
+uint8_t TimerService_After(uint32_t delay, void (*task)(void)){
+  return TimerService_Add(TimerService_Now() + delay, 0, task);
+}
+
+// ------------TimerService_Every------------
+// Run a task every period usec.
+uint8_t TimerService_Every(uint32_t period, void (*task)(void)){
+  if(period < TIMER_MIN_PERIOD){
+    period = TIMER_MIN_PERIOD;          // the handler must finish within a period
+  }
+  return TimerService_Add(TimerService_Now() + period, period, task);
+}
+
+// ------------TimerService_Cancel------------
+// Remove a pending event.
+uint8_t TimerService_Cancel(uint8_t handle){
+  uint8_t i, found = 0;
+  long sr = StartCritical();
+  for(i = 0; i < Pending; i++){
+    if(Order[i] == handle){
+      found = 1;
+    }
+    if(found && i + 1 < Pending){
+      Order[i] = Order[i+1];
+    }
+  }
+  if(found){
+    Pending--;
+    Free |= 1<<handle;
+    TimerService_Arm();
+  }
+  EndCritical(sr);
+  return found;
+}
+
+// earliest event due, run every event that is due
+void TA1_0_IRQHandler(void){
+  PROFILE_ENTER(PROFILE_TIMER);
+  uint8_t s, i;
+  uint32_t missed;
+  uint32_t now = TimerService_Now();
+  TIMER_A1->CCTL[0] &= ~0x0001;         // acknowledge CCIFG
+  while(Pending && (int32_t)(Slot[Order[0]].due - now) < TIMER_SOON){
+    s = Order[0];
+    for(i = 1; i < Pending; i++){       // pop the head
+      Order[i-1] = Order[i];
+    }
+    Pending--;
+    if(now - Slot[s].due > TimerLateMax && (int32_t)(now - Slot[s].due) > 0){
+      TimerLateMax = now - Slot[s].due;
+    }
+    if(Slot[s].period){                 // periodic, due one period after the last due time
+      Slot[s].due += Slot[s].period;
+      if((int32_t)(Slot[s].due - now) < TIMER_SOON){ // fell behind, skip to the next period ahead
+        missed = (now + TIMER_SOON - Slot[s].due + Slot[s].period - 1)/Slot[s].period;
+        Slot[s].due += missed*Slot[s].period;
+        TimerSkipped += missed;
+      }
+      TimerService_Insert(s, now);
+    }else{
+      Free |= 1<<s;
+    }
+    TimerFired++;
+    Slot[s].task();                     // may add or cancel events
+    now = TimerService_Now();
+  }
+  TimerService_Arm();
+  PROFILE_EXIT(PROFILE_TIMER);
+}
+
+// overflow, upper 16 bits of the clock
+void TA1_N_IRQHandler(void){
+  if(TIMER_A1->CTL&0x0001){
+    TIMER_A1->CTL &= ~0x0001;           // acknowledge TAIFG
+    Overflows++;
+    TimerService_Arm();                 // an event may now be within one wrap
+  }
+}
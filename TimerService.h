@@ -0,0 +1,75 @@
+// TimerService.h
+// One-shot and periodic callbacks at a precise future time on
+// Timer A1.  TA1 counts SMCLK/12 = 1 MHz continuously; an
+// overflow count extends it to a 32-bit microsecond clock
+// that wraps after 71 minutes.  Pending events sit in a fixed
+// array of slots kept sorted by due time, and CCR0 is armed
+// for the earliest one, so a callback runs within the
+// interrupt latency of its due microsecond.
+// The resolution is one timer count, 1 usec or 48 bus cycles at
+// 48 MHz, so callbacks jitter by up to 1 usec plus the interrupt
+// latency; use the DWT timebase, Timebase.h, for finer timing.
+// Callbacks run in the TA1 interrupt; keep them short.
+// FSM_Main runs the wheel loops as a periodic event, paused
+// while the robot stands still.
+
+#ifndef TIMERSERVICE_H_
+#define TIMERSERVICE_H_
+#include <stdint.h>
+
+#define TIMER_SLOTS 8                   // events pending at once
+#define TIMER_NONE  0xFF                // no free slot, or no event
+#define TIMER_MIN_PERIOD 50             // usec, shortest periodic event
+
+extern uint32_t TimerFired;             // callbacks run
+extern uint32_t TimerSkipped;           // periods a late periodic event did not run
+extern uint32_t TimerLateMax;           // largest usec between due time and callback
+extern uint32_t TimerFull;              // events refused, every slot in use
+
+// ------------TimerService_Init------------
+// Start Timer A1 as the microsecond clock with no events.
+// Input: priority  0 (high) to 7 (low) for both TA1 interrupts
+// Output: none
+void TimerService_Init(uint32_t priority);
+
+// ------------TimerService_Now------------
+// Microsecond clock.
+// Input: none
+// Output: usec since TimerService_Init(), wraps at 2^32
+uint32_t TimerService_Now(void);
+
+// ------------TimerService_At------------
+// Run a task once at a given time.
+// Input: time  due time in usec on the TimerService_Now() clock,
+//              less than 2^31 usec ahead
+//        task  callback, runs in the TA1 interrupt
+// Output: event handle for TimerService_Cancel, TIMER_NONE if full
+uint8_t TimerService_At(uint32_t time, void (*task)(void));
+
+// ------------TimerService_After------------
+// Run a task once, delay usec from now.
+// Input: delay  usec from now, 0 runs it as soon as possible
+//        task   callback, runs in the TA1 interrupt
+// Output: event handle for TimerService_Cancel, TIMER_NONE if full
+uint8_t TimerService_After(uint32_t delay, void (*task)(void));
+
+// ------------TimerService_Every------------
+// Run a task every period usec, first one period from now.
+// Due times advance by exactly one period, so a late callback
+// does not shift the ones after it.  Periods that have already
+// passed when a callback returns are skipped, not run back to
+// back, and counted in TimerSkipped.
+// Input: period  usec between runs, TIMER_MIN_PERIOD or more
+//        task    callback, runs in the TA1 interrupt
+// Output: event handle for TimerService_Cancel, TIMER_NONE if full
+uint8_t TimerService_Every(uint32_t period, void (*task)(void));
+
+// ------------TimerService_Cancel------------
+// Remove a pending event.  Safe from a callback, including a
+// periodic event's own.  A one-shot handle is only valid until
+// the event runs; the slot is then reused.
+// Input: handle  from TimerService_At, _After or _Every
+// Output: 1 if the event was pending, 0 if not
+uint8_t TimerService_Cancel(uint8_t handle);
+
+#endif /* TIMERSERVICE_H_ */
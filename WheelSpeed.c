@@ -0,0 +1,128 @@
+// WheelSpeed.c
+// Closed-loop wheel speed on top of the encoder driver.
+// Duty = kff*target + PI(target - speed), through Motor_Set().
+
+#include <stdint.h>
+#include "Encoder.h"
+#include "Motor.h"
+#include "PID.h"
+#include "WheelSpeed.h"
+
+PID_t WheelPID[2];                      // ENCODER_RIGHT, ENCODER_LEFT
+int32_t WheelTarget[2];                 // commanded speed, mm/s
+int32_t WheelDuty[2];                   // last duty sent to the motors
+int32_t WheelFF;                        // Q16 duty per mm/s
+uint8_t WheelIdle = 1;                  // 1 after WheelSpeed_Stop(), no motor writes
+uint8_t StopRunning = 0;                // 1 while a stop is being measured
+uint32_t StopElapsed;                   // ms since the stop command
+uint32_t StopMs, StopUm;                // last stop: time to the last edge, distance
+int32_t StopFrom[2], StopSeen[2];       // ticks at the command, ticks last step
+
+// ------------WheelSpeed_Init------------
+// Start the encoders and set the loop gains, wheels stopped.
+void WheelSpeed_Init(int32_t kff, int32_t kp, int32_t ki,
+                     int32_t iMax, int32_t outMax){
+  int i;
+  Encoder_Init();
+  WheelFF = kff;
+  for(i=0; i<2; i++){
+    PID_Init(&WheelPID[i], kp, ki, 0, 0, outMax, iMax);
+    WheelTarget[i] = 0;
+    WheelDuty[i] = 0;
+  }
+  WheelIdle = 1;
+}
+
+// ------------WheelSpeed_Set------------
+// Command both wheel speeds.
+void WheelSpeed_Set(int32_t left, int32_t right){
+  WheelTarget[ENCODER_LEFT] = left;
+  WheelTarget[ENCODER_RIGHT] = right;
+  WheelIdle = 0;
+  StopRunning = 0;
+}
+
+// stop the loops and start measuring the stop
+static void WheelSpeed_Hold(void){
+  int i;
+  WheelIdle = 1;
+  for(i=0; i<2; i++){
+    WheelTarget[i] = 0;
+    PID_Reset(&WheelPID[i]);
+    StopFrom[i] = StopSeen[i] = Encoder_Ticks(i);
+  }
+  StopElapsed = 0;
+  StopMs = 0;
+  StopRunning = 1;
+}
+
+// ------------WheelSpeed_Stop------------
+// Coast both motors and hold them off.
+void WheelSpeed_Stop(void){
+  Motor_Stop();
+  WheelSpeed_Hold();
+}
+
+// ------------WheelSpeed_Brake------------
+// Brake both motors and hold them there.
+void WheelSpeed_Brake(void){
+  Motor_Brake();
+  WheelSpeed_Hold();
+}
+
+// ------------WheelSpeed_Stopping------------
+// Result of the last stopping measurement.
+uint8_t WheelSpeed_Stopping(uint32_t *ms, uint32_t *um){
+  *ms = StopMs;
+  *um = StopUm;
+  return !StopRunning;
+}
+
+// follow the wheels after a stop command until both are still
+static void WheelSpeed_Measure(uint32_t ms){
+  int i;
+  int32_t moved = 0, ticks;
+  StopElapsed += ms;
+  for(i=0; i<2; i++){
+    ticks = Encoder_Ticks(i);
+    if(ticks != StopSeen[i]){
+      StopSeen[i] = ticks;
+      StopMs = StopElapsed;             // newest edge so far
+    }
+    moved += (ticks > StopFrom[i]) ? ticks - StopFrom[i] : StopFrom[i] - ticks;
+  }
+  StopUm = (moved*ENCODER_UM_PER_TICK)/2;
+  if(Encoder_Speed(ENCODER_LEFT) == 0 && Encoder_Speed(ENCODER_RIGHT) == 0){
+    StopRunning = 0;                    // both stalled, no edge for the stall time
+  }
+}
+
+// ------------WheelSpeed_Step------------
+// Measure the wheel speeds and run both loops once.
+void WheelSpeed_Step(uint32_t ms){
+  int i;
+  Encoder_Step(ms);
+  if(StopRunning){
+    WheelSpeed_Measure(ms);
+  }
+  if(WheelIdle){
+    return;
+  }
+  for(i=0; i<2; i++){
+    if(WheelTarget[i] == 0){
+      PID_Reset(&WheelPID[i]);          // no creep or windup while stopped
+      WheelDuty[i] = 0;
+    }else{
+      WheelDuty[i] = (int32_t)(((int64_t)WheelFF*WheelTarget[i]) >> 16) +
+                     PID_Step(&WheelPID[i], WheelTarget[i] - Encoder_Speed(i));
+    }
+  }
+  Motor_Set(WheelDuty[ENCODER_LEFT], WheelDuty[ENCODER_RIGHT]); // skipped when unchanged
+}
+
+// ------------WheelSpeed_Still------------
+// Nothing to do until the next command.
+uint8_t WheelSpeed_Still(void){
+  return (WheelIdle || (WheelTarget[0] == 0 && WheelTarget[1] == 0)) && !StopRunning &&
+         Encoder_Speed(ENCODER_LEFT) == 0 && Encoder_Speed(ENCODER_RIGHT) == 0;
+}
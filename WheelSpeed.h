@@ -0,0 +1,67 @@
+// WheelSpeed.h
+// Closed-loop wheel speed.  Each wheel runs a PI loop on the
+// encoder speed plus a feed-forward duty proportional to the
+// commanded speed, so a wheel holds its speed as the battery
+// drains or the friction changes.
+
+#ifndef WHEELSPEED_H_
+#define WHEELSPEED_H_
+#include <stdint.h>
+
+// ------------WheelSpeed_Init------------
+// Start the encoders and set the loop gains, wheels stopped.
+// Input: kff     Q16 duty per mm/s, feed-forward
+//        kp, ki  Q16 PI gains on the speed error in mm/s, per step
+//        iMax    integral term limit, duty
+//        outMax  PI correction limit, duty
+// Output: none
+void WheelSpeed_Init(int32_t kff, int32_t kp, int32_t ki,
+                     int32_t iMax, int32_t outMax);
+
+// ------------WheelSpeed_Set------------
+// Command both wheel speeds.
+// Input: left, right  signed speed in mm/s, negative is backward
+// Output: none
+void WheelSpeed_Set(int32_t left, int32_t right);
+
+// ------------WheelSpeed_Stop------------
+// Coast: power down both drivers now (Motor_Stop) and hold
+// them off until the next WheelSpeed_Set().  Starts a
+// stopping measurement.
+// Input: none
+// Output: none
+void WheelSpeed_Stop(void);
+
+// ------------WheelSpeed_Brake------------
+// Brake: short both motors now (Motor_Brake) and hold them
+// there until the next WheelSpeed_Set().  Starts a stopping
+// measurement.
+// Input: none
+// Output: none
+void WheelSpeed_Brake(void);
+
+// ------------WheelSpeed_Stopping------------
+// Result of the last stopping measurement, from the stop
+// command to the last encoder edge of either wheel.
+// Input: ms  time to stop
+//        um  distance rolled, mean of both wheels
+// Output: 1 once both wheels have stopped, 0 while still rolling
+uint8_t WheelSpeed_Stopping(uint32_t *ms, uint32_t *um);
+
+// ------------WheelSpeed_Step------------
+// Measure the wheel speeds and run both loops once.  Call at
+// a fixed rate; constant time, no loops over edges.
+// Input: ms  time since the previous call
+// Output: none
+void WheelSpeed_Step(uint32_t ms);
+
+// ------------WheelSpeed_Still------------
+// Nothing to do until the next command: both speeds are 0 or
+// the drivers are held off, no stop is being measured, and
+// both wheels have stalled.  WheelSpeed_Step() may pause
+// until the next WheelSpeed_Set(), _Stop() or _Brake().
+// Input: none
+// Output: 1 if still, 0 if the loops still have work
+uint8_t WheelSpeed_Still(void);
+
+#endif /* WHEELSPEED_H_ */
@@ -89,6 +89,8 @@ SECTIONS
     /* device specific purposes:                                             */
     /* Flash mailbox for device security operations                          */
     .flashMailbox : > 0x00200000
+    /* 0x00200800-0x00200FFF of the mailbox sector holds the reflectance     */
+    /* calibration profile, written at run time by InfoFlash.c              */
     /* TLV table for device identification and characterization              */
     .tlvTable     : > 0x00201000
     /* BSL area for device bootstrap loader                                  */
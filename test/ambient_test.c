@@ -0,0 +1,94 @@
+// ambient_test.c
+// Replay a decay trace through the capture engine in each
+// ambient mode, and check which modes still find the line.
+// A trace frame holds the decay time of every channel under
+// its emitter alone and under the ambient light alone, in
+// usec, 0 for no ambient light.  Photocurrents add, so the
+// lit channel decays in emit*ambient/(emit + ambient).
+#include <stdint.h>
+#include "msp.h"
+#include "Reflectance.h"
+#include "qtr.h"
+#include "check.h"
+
+typedef struct {
+  uint16_t emit[8];                     // emitter only
+  uint16_t ambient[8];                  // ambient only, 0 for dark
+  uint8_t line;                         // channels over the line
+} TraceFrame_t;
+
+#define W 200                           // white under the emitter
+#define B 1500                          // black under the emitter
+#define N 0                             // no ambient light
+// indoors, then into a sunlit patch and out again
+static const TraceFrame_t Trace[] = {
+  {{W,W,W,B,B,W,W,W}, {N,N,N,N,N,N,N,N}, 0x18},
+  {{W,W,B,B,W,W,W,W}, {4000,4000,4000,4000,4000,4000,4000,4000}, 0x0C},
+  {{W,W,W,B,B,W,W,W}, {1500,1400,1300,1200,1100,1000,900,800}, 0x18},
+  {{W,W,W,W,B,B,W,W}, {600,600,600,600,600,600,600,600}, 0x30},
+  {{W,W,W,W,W,B,B,W}, {400,420,440,460,480,500,520,540}, 0x60},
+  {{W,W,W,W,B,B,W,W}, {800,800,800,800,800,800,800,800}, 0x30},
+  {{W,W,W,B,B,W,W,W}, {N,N,N,N,N,N,N,N}, 0x18},
+};
+#define TRACE_FRAMES (sizeof(Trace)/sizeof(Trace[0]))
+#define STEP 25                         // sample interval, CAL_STEP in Calibration.c
+static const uint16_t Threshold[8] = {800, 800, 800, 800, 800, 800, 800, 800};
+
+// capture one trace frame, return the thresholded reading
+static uint8_t replay(const TraceFrame_t *f, uint32_t *elapsed){
+  uint16_t lit[8], dark[8], time[8];
+  uint32_t e, a;
+  int i;
+  for(i=0; i<8; i++){
+    e = f->emit[i];
+    a = f->ambient[i];
+    lit[i] = a ? e*a/(e + a) : e;
+    dark[i] = a ? a : 0xFFFF;
+  }
+  Qtr_Set(lit, dark);
+  CHECK(Reflectance_StartDecay(STEP, 5000) == 0);
+  Qtr_Run(5000);
+  *elapsed = QtrNow;
+  CHECK(Reflectance_GetDecay(time) == 1);
+  return Reflectance_Threshold(time, Threshold);
+}
+
+// a whole capture must end before the next 10 ms sense period
+static void test_frame_time(uint8_t mode){
+  static const uint16_t slow[8] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
+  uint16_t time[8];
+  int interrupts;
+  Reflectance_SetAmbient(mode);
+  Qtr_Set(slow, slow);                  // nothing decays, every sub-frame times out
+  CHECK(Reflectance_StartDecay(STEP, 5000) == 0);
+  interrupts = Qtr_Run(5000);
+  CHECK(QtrNow <= REFLECTANCE_FRAME_US - 100);
+  CHECK(Reflectance_GetDecay(time) == 1);
+  CHECK(interrupts <= REFLECTANCE_FRAME_US/STEP + 3); // one per step, plus the charges
+  printf("mode %u: longest capture %lu us, %d interrupts\n", mode, (unsigned long)QtrNow, interrupts);
+}
+
+static int replay_mode(uint8_t mode){
+  uint32_t elapsed;
+  unsigned k;
+  int wrong = 0;
+  Reflectance_SetAmbient(mode);
+  for(k=0; k<TRACE_FRAMES; k++){
+    if(replay(&Trace[k], &elapsed) != Trace[k].line){
+      wrong++;
+    }
+  }
+  printf("mode %u: %d of %u frames misread\n", mode, wrong, (unsigned)TRACE_FRAMES);
+  return wrong;
+}
+
+int main(void){
+  Reflectance_Init();
+  test_frame_time(REFLECTANCE_AMBIENT_OFF);
+  test_frame_time(REFLECTANCE_AMBIENT_DIFF);
+  test_frame_time(REFLECTANCE_AMBIENT_SPLIT);
+  CHECK(replay_mode(REFLECTANCE_AMBIENT_OFF) > 0);   // sunlight reads as white
+  CHECK(replay_mode(REFLECTANCE_AMBIENT_DIFF) == 0);
+  CHECK(replay_mode(REFLECTANCE_AMBIENT_SPLIT) == 0);
+  return Check_Done("ambient_test");
+}
@@ -0,0 +1,104 @@
+// avoid_test.c
+// Detours around an obstacle on a kinematic model of the
+// robot, with the maneuver from FSM_Main.c.  The line is the
+// x axis, the robot bumps a 60 mm disc sitting on it and must
+// go around without touching it and find the line again.
+#include <stdint.h>
+#include <math.h>
+#include "Avoid.h"
+#include "check.h"
+
+// maneuver as in FSM_Main.c
+#define AVOID_BRAKE_MS  150
+#define AVOID_BACK_MS   400
+#define AVOID_TURN_MS   350
+#define AVOID_ARC_MS    1600
+#define AVOID_SEEK_MS   2000
+#define AVOID_BACK_DUTY 3000
+#define AVOID_TURN_DUTY 4000
+#define AVOID_OUTER     4000
+#define AVOID_INNER     2400
+#define AVOID_SEEK_INNER 1000
+
+#define MM_PER_S   (550.0/10000)        // wheel speed per duty
+#define TRACK_MM   140.0                // wheel to wheel
+#define AHEAD_MM   70.0                 // sensor bar ahead of the axle
+#define PITCH_MM   9.5                  // sensor spacing
+#define ROBOT_R    70.0                 // chassis radius
+#define OBSTACLE_X 400.0
+#define OBSTACLE_R 60.0
+
+static double X, Y, H;                  // axle center, mm; heading, rad
+
+// sensors over the 19 mm line along y = 0, bit 0 is the right end
+static uint8_t sense(void){
+  uint8_t data = 0;
+  int i;
+  for(i=0; i<8; i++){
+    double lat = (3.5 - i)*PITCH_MM;    // left of the center is positive
+    double sy = Y + AHEAD_MM*sin(H) + lat*cos(H);
+    if(fabs(sy) < PITCH_MM) data |= 1<<i;
+  }
+  return data;
+}
+
+// bump the obstacle offset 'oy' mm from the line and run the
+// detour, 1 ms steps; returns the ms it took, -1 if it missed
+static int detour(uint8_t bump, double oy, int8_t side, double *clearance){
+  Avoid_t a;
+  int32_t left = 0, right = 0;
+  uint32_t t;
+  uint8_t phase;
+  double vl, vr, c;
+  Avoid_Init(&a, AVOID_BRAKE_MS, AVOID_BACK_MS, AVOID_TURN_MS, AVOID_ARC_MS, AVOID_SEEK_MS,
+             AVOID_BACK_DUTY, AVOID_TURN_DUTY, AVOID_OUTER, AVOID_INNER, AVOID_SEEK_INNER);
+  X = OBSTACLE_X - OBSTACLE_R - ROBOT_R;  // touching, on the line
+  Y = 0;
+  H = 0;
+  *clearance = 1e9;
+  Avoid_Bump(&a, bump, 1, 0);
+  CHECK(a.side == side);
+  for(t=0; t<10000; t++){
+    phase = Avoid_Step(&a, sense(), t, &left, &right);
+    if(phase == AVOID_IDLE) break;
+    if(phase == AVOID_BRAKE) left = right = 0;
+    vl = left*MM_PER_S;
+    vr = right*MM_PER_S;
+    H += (vr - vl)/TRACK_MM*1e-3;
+    X += (vl + vr)/2*cos(H)*1e-3;
+    Y += (vl + vr)/2*sin(H)*1e-3;
+    c = hypot(X - OBSTACLE_X, Y - oy) - OBSTACLE_R - ROBOT_R;
+    if(phase >= AVOID_TURN && c < *clearance) *clearance = c; // closest pass after backing off
+  }
+  printf("bump %02X: detour %+d, %u ms, rejoined at x=%.0f heading %.0f deg, clearance %.0f mm\n",
+         bump, a.side, t, X, H*57.2958, *clearance);
+  CHECK(t < 10000);                     // bounded by the phase lengths
+  CHECK(a.detours == 1);
+  if(a.rejoined != 1 || a.missed) return -1;
+  CHECK(a.lastMs == t);
+  return t;
+}
+
+int main(void){
+  double clearance;
+  int ms;
+
+  // touched on the left, obstacle a little left of the line: go right
+  ms = detour(0xE0, 20, 1, &clearance);
+  CHECK(ms > 0 && ms < 4500);
+  CHECK(clearance > 0);                 // never touches it on the way round
+  CHECK(X > OBSTACLE_X);                // past it, not back where it started
+
+  ms = detour(0x0D, -20, -1, &clearance);
+  CHECK(ms > 0 && ms < 4500);
+  CHECK(clearance > 0);
+  CHECK(X > OBSTACLE_X);
+
+  // one switch each side, the hint picks the side
+  ms = detour(0x28, 0, 1, &clearance);
+  CHECK(ms > 0 && ms < 4500);
+  CHECK(clearance > 0);
+  CHECK(X > OBSTACLE_X);
+
+  return Check_Done("avoid_test");
+}
@@ -0,0 +1,78 @@
+// capture_test.c
+// Phase sequencing of the Timer A2 reflectance capture
+// engine in Reflectance.c, against the P7 model in qtr.c.
+#include <stdint.h>
+#include "msp.h"
+#include "Reflectance.h"
+#include "qtr.h"
+#include "check.h"
+
+extern volatile uint8_t CapturePhase;
+
+// black line under sensors 4 and 5, white elsewhere
+static const uint16_t LineLit[8]  = {150, 160, 170, 900, 950, 180, 160, 150};
+static const uint16_t LineDark[8] = {3000, 3000, 3000, 3000, 3000, 3000, 3000, 3000};
+
+// binary frames: charge 10 us, decay for the threshold time, read
+static void test_binary(void){
+  uint8_t data = 0;
+  CHECK(Reflectance_GetFrame(&data) == 0);  // nothing captured yet
+  CHECK(Reflectance_StartCapture(500) == 0);
+  CHECK(CapturePhase == 1);                 // CHARGE
+  CHECK(P7->DIR == 0xFF && P7->OUT == 0xFF);
+  CHECK((P5->OUT&0x08) && (P9->OUT&0x04));  // both emitter banks on
+  CHECK(TIMER_A2->CCR[0] == 10*12 - 1);     // 10 us of SMCLK
+  CHECK(Reflectance_StartCapture(500) == 1);// busy
+  CHECK(Reflectance_GetFrame(&data) == 0);
+
+  CHECK(Qtr_Fire() == 1);
+  CHECK(CapturePhase == 2);                 // DECAY
+  CHECK(P7->DIR == 0x00);                   // released
+  CHECK(TIMER_A2->CCR[0] == 500*12 - 1);
+
+  CHECK(Qtr_Fire() == 1);
+  CHECK(CapturePhase == 0);                 // IDLE
+  CHECK((P5->OUT&0x08) == 0 && (P9->OUT&0x04) == 0);
+  CHECK((TIMER_A2->CTL&0x0030) == 0);       // timer stopped
+  CHECK(Qtr_Fire() == 0);                   // no stray interrupt
+  CHECK(Reflectance_GetFrame(&data) == 1);
+  CHECK(data == 0x18);
+  CHECK(Reflectance_GetFrame(&data) == 0);  // each frame read once
+  CHECK(QtrNow == 510);
+
+  CHECK(Reflectance_StartCapture(100000) == 0); // clamped to the 16-bit timer
+  CHECK(Qtr_Run(10) == 2);
+  CHECK(Reflectance_GetFrame(&data) == 1);
+  CHECK(data == 0x00);                      // everything decayed by 5 ms
+}
+
+// decay-time frames: periodic samples until every channel fell
+static void test_decay(void){
+  uint16_t time[8];
+  int isr;
+  Reflectance_SetAmbient(REFLECTANCE_AMBIENT_OFF);
+  CHECK(Reflectance_StartDecay(10, 2000) == 0);
+  CHECK(Reflectance_StartCapture(500) == 1);
+  CHECK(Reflectance_GetDecay(time) == 0);
+  isr = Qtr_Run(1000);
+  CHECK(isr == 1 + 95);                     // charge, then samples to 950 us
+  CHECK(CapturePhase == 0);
+  CHECK(Reflectance_GetDecay(time) == 1);
+  CHECK(time[0] == 150 && time[1] == 160 && time[2] == 170 && time[3] == 900);
+  CHECK(time[4] == 950 && time[5] == 180 && time[6] == 160 && time[7] == 150);
+  CHECK(Reflectance_GetDecay(time) == 0);
+
+  CHECK(Reflectance_StartDecay(10, 500) == 0);  // timeout before the line decays
+  Qtr_Run(1000);
+  CHECK(Reflectance_GetDecay(time) == 1);
+  CHECK(time[3] == 500 && time[4] == 500 && time[0] == 150);
+}
+
+int main(void){
+  Reflectance_Init();
+  Qtr_Set(LineLit, LineDark);
+  test_binary();
+  Qtr_Set(LineLit, LineDark);
+  test_decay();
+  return Check_Done("capture_test");
+}
@@ -0,0 +1,59 @@
+// clock_test.c
+#define _POSIX_C_SOURCE 200112L
+// Clock_Init48MHz() on the register stand-ins when the power
+// manager or the crystal never becomes ready.  The init gives
+// up and the bus stays on the 3 MHz DCO, but the DWT counter
+// must still be running so Clock_Delay1us() and _Delay1ms()
+// return instead of spinning forever.
+#include <stdint.h>
+#include <unistd.h>
+#include "msp.h"
+#include "Clock.h"
+#include "Timebase.h"
+#include "check.h"
+
+// cycles a delay took on the counter
+static uint32_t delay_us(uint32_t n){
+  uint32_t start = DWT_s.CYCCNT;
+  Clock_Delay1us(n);
+  return DWT_s.CYCCNT - start;
+}
+
+int main(void){
+  uint32_t cycles;
+
+  alarm(10);                            // a delay that spins kills the test
+  HostCycleStep = 1;                    // the counter runs once it is enabled
+
+  // power manager busy from reset, the first wait times out
+  PCM_s.CTL1 = 0x00000100;
+  Clock_Init48MHz();
+  CHECK(Clock_GetFreq() == 3000000);
+  CHECK(CoreDebug_s.DEMCR&CoreDebug_DEMCR_TRCENA_Msk);
+  CHECK(DWT_s.CTRL&DWT_CTRL_CYCCNTENA_Msk);
+  CHECK(Timebase_UsToCycles(1000) == 3000);
+  cycles = delay_us(1000);
+  printf("power manager time out: 1000 us delay took %lu cycles at 3 MHz\n", (unsigned long)cycles);
+  CHECK(cycles >= 3000 && cycles < 3100);
+  Clock_Delay1ms(2);                    // returns, or the alarm fires
+
+  // power manager ready, the crystal never settles
+  PCM_s.CTL1 = 0;
+  PCM_s.CTL0 = 0x00000100;              // already in active mode LDO VCORE1
+  CS_s.IFG = 0x00000002;                // HFXT fault stays set
+  Clock_Init48MHz();
+  CHECK(Clock_GetFreq() == 3000000);
+  cycles = delay_us(1000);
+  printf("crystal time out: 1000 us delay took %lu cycles at 3 MHz\n", (unsigned long)cycles);
+  CHECK(cycles >= 3000 && cycles < 3100);
+
+  // crystal good, the delays follow the switch to 48 MHz
+  CS_s.IFG = 0;
+  Clock_Init48MHz();
+  CHECK(Clock_GetFreq() == 48000000);
+  cycles = delay_us(1000);
+  printf("48 MHz: 1000 us delay took %lu cycles\n", (unsigned long)cycles);
+  CHECK(cycles >= 48000 && cycles < 48100);
+
+  return Check_Done("clock_test");
+}
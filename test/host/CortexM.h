@@ -0,0 +1,17 @@
+// CortexM.h
+// Host stand-in for the RSLK CortexM.h.  Interrupts are not
+// masked on the PC; WaitForInterrupt() calls HostIdle, which
+// a test sets to deliver the next interrupt of its model.
+#ifndef CORTEXM_H_
+#define CORTEXM_H_
+#include <stdint.h>
+
+extern void (*HostIdle)(void);
+
+void DisableInterrupts(void);
+void EnableInterrupts(void);
+long StartCritical(void);
+void EndCritical(long sr);
+void WaitForInterrupt(void);
+
+#endif /* CORTEXM_H_ */
@@ -0,0 +1,12 @@
+// LaunchPad.h
+// Host stand-in for the RSLK LaunchPad.h, see LaunchPad.c.
+#ifndef LAUNCHPAD_H_
+#define LAUNCHPAD_H_
+#include <stdint.h>
+
+void LaunchPad_Init(void);
+uint8_t LaunchPad_Input(void);
+void LaunchPad_LED(uint8_t data);
+void LaunchPad_Output(uint8_t data);
+
+#endif /* LAUNCHPAD_H_ */
@@ -0,0 +1,9 @@
+// SysTickInts.h
+// Host stand-in for the RSLK SysTickInts.h, see SysTickInts.c.
+#ifndef SYSTICKINTS_H_
+#define SYSTICKINTS_H_
+#include <stdint.h>
+
+void SysTick_Init(uint32_t period, uint32_t priority);
+
+#endif /* SYSTICKINTS_H_ */
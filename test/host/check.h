@@ -0,0 +1,24 @@
+// check.h
+// Minimal assertions for the host tests.  A failed CHECK
+// prints its location and the test exits nonzero.
+
+#ifndef CHECK_H_
+#define CHECK_H_
+#include <stdio.h>
+
+static int Failures = 0;
+
+#define CHECK(cond) do{ \
+    if(!(cond)){ \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      Failures++; \
+    } \
+  }while(0)
+
+// print the verdict, returns the exit status for main()
+static int Check_Done(const char *name){
+  printf("%s: %s\n", name, Failures ? "FAIL" : "ok");
+  return Failures ? 1 : 0;
+}
+
+#endif /* CHECK_H_ */
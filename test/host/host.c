@@ -0,0 +1,73 @@
+// host.c
+// Register blocks and board functions the modules under test
+// link against on the PC.  Tests drive and inspect these.
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <sys/mman.h>
+#include "msp.h"
+#include "CortexM.h"
+
+DIO_PORT_Type P1_s, P2_s, P3_s, P4_s, P5_s, P6_s, P7_s, P8_s, P9_s, P10_s, PJ_s;
+Timer_A_Type TA0_s, TA1_s, TA2_s, TA3_s;
+SysTick_Type SysTick_s;
+SCB_Type SCB_s;
+NVIC_Type NVIC_s;
+DWT_Type DWT_s;
+CoreDebug_Type CoreDebug_s;
+ADC14_Type ADC14_s;
+FLCTL_Type FLCTL_s;
+PCM_Type PCM_s;
+CS_Type CS_s;
+
+uint32_t HostCycleStep = 0;
+DWT_Type *Host_Dwt(void){
+  if((CoreDebug_s.DEMCR&CoreDebug_DEMCR_TRCENA_Msk) && (DWT_s.CTRL&DWT_CTRL_CYCCNTENA_Msk)){
+    DWT_s.CYCCNT += HostCycleStep;
+  }
+  return &DWT_s;
+}
+
+// the legacy blocking reads still reference the delays, and
+// a test can see how long the firmware would have spun; weak,
+// so a test that links the real Clock.c gets that instead
+uint64_t HostDelayUs = 0;
+__attribute__((weak)) void Clock_Delay1us(uint32_t n){ HostDelayUs += n; }
+__attribute__((weak)) void Clock_Delay1ms(uint32_t n){ HostDelayUs += 1000*(uint64_t)n; }
+__attribute__((weak)) uint32_t Clock_GetFreq(void){ return 48000000; }
+__attribute__((weak)) void Clock_Init48MHz(void){}
+
+static void Host_Nothing(void){}
+void (*HostIdle)(void) = Host_Nothing;
+void DisableInterrupts(void){}
+void EnableInterrupts(void){}
+long StartCritical(void){ return 0; }
+void EndCritical(long sr){}
+void WaitForInterrupt(void){ HostIdle(); }
+
+// one word per bit-band alias the firmware takes
+#define HOST_ALIASES 16
+static struct { volatile void *reg; int bit; volatile uint32_t word; } Alias[HOST_ALIASES];
+volatile uint32_t *Host_BitBand(volatile void *reg, int bit){
+  int i;
+  for(i=0; i<HOST_ALIASES; i++){
+    if(Alias[i].reg == 0){
+      Alias[i].reg = reg;
+      Alias[i].bit = bit;
+    }
+    if((Alias[i].reg == reg) && (Alias[i].bit == bit)){
+      return &Alias[i].word;
+    }
+  }
+  return &Alias[0].word;                  // out of aliases, tests see the wrong pin
+}
+
+// INFO flash bank 0 at its device address, so that firmware
+// reading a record through a fixed pointer works unchanged
+void *Host_InfoFlash(void){
+  void *info = mmap((void *)0x00200000, 0x1000, PROT_READ|PROT_WRITE,
+                    MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+  if(info != (void *)0x00200000){
+    return 0;
+  }
+  return info;
+}
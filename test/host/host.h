@@ -0,0 +1,15 @@
+// host.h
+// What host.c gives the tests beyond the register blocks.
+#ifndef HOST_H_
+#define HOST_H_
+#include <stdint.h>
+
+extern uint64_t HostDelayUs;            // usec the firmware spent in Clock_Delay*
+
+// ------------Host_InfoFlash------------
+// Map 4 KB of RAM where INFO flash bank 0 sector 0 is.
+// Input: none
+// Output: 0x00200000, or 0 if that address is taken
+void *Host_InfoFlash(void);
+
+#endif /* HOST_H_ */
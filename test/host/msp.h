@@ -0,0 +1,128 @@
+// msp.h
+// Host stand-in for the TI device header, for the tests in
+// test/.  Each peripheral is an ordinary struct in RAM with
+// the register names the firmware uses, so a module can be
+// compiled on the PC and its register writes checked, or its
+// inputs (P7->IN, ...) driven by a model.  Layouts are not the
+// silicon's, only the names.
+
+#ifndef HOST_MSP_H_
+#define HOST_MSP_H_
+#include <stdint.h>
+
+#define __IO volatile
+#define __I  volatile const
+#define __O  volatile
+
+// ARM assembly in a module (Clock.c delay()) does not run here
+#define __asm(code)
+
+typedef struct {
+  __IO uint8_t IN, OUT, DIR, REN, DS, SEL0, SEL1, SELC, IES, IE, IFG;
+  __IO uint16_t IV;
+} DIO_PORT_Type;
+extern DIO_PORT_Type P1_s, P2_s, P3_s, P4_s, P5_s, P6_s, P7_s, P8_s, P9_s, P10_s, PJ_s;
+#define P1  (&P1_s)
+#define P2  (&P2_s)
+#define P3  (&P3_s)
+#define P4  (&P4_s)
+#define P5  (&P5_s)
+#define P6  (&P6_s)
+#define P7  (&P7_s)
+#define P8  (&P8_s)
+#define P9  (&P9_s)
+#define P10 (&P10_s)
+#define PJ  (&PJ_s)
+
+typedef struct {
+  __IO uint16_t CTL;
+  __IO uint16_t CCTL[7];
+  __IO uint16_t R;
+  __IO uint16_t CCR[7];
+  __IO uint16_t EX0;
+  __I  uint16_t IV;
+} Timer_A_Type;
+extern Timer_A_Type TA0_s, TA1_s, TA2_s, TA3_s;
+#define TIMER_A0 (&TA0_s)
+#define TIMER_A1 (&TA1_s)
+#define TIMER_A2 (&TA2_s)
+#define TIMER_A3 (&TA3_s)
+
+typedef struct { __IO uint32_t CTRL, LOAD, VAL; __I uint32_t CALIB; } SysTick_Type;
+extern SysTick_Type SysTick_s;
+#define SysTick (&SysTick_s)
+#define SysTick_LOAD_RELOAD_Msk 0xFFFFFFUL
+
+typedef struct { __I uint32_t CPUID; __IO uint32_t ICSR, VTOR, AIRCR, SCR, CCR; __IO uint8_t SHP[12]; } SCB_Type;
+extern SCB_Type SCB_s;
+#define SCB (&SCB_s)
+#define SCB_SCR_SLEEPONEXIT_Msk (1UL<<1)
+#define SCB_SCR_SLEEPDEEP_Msk   (1UL<<2)
+#define SCB_ICSR_PENDSTSET_Msk  (1UL<<26)
+
+typedef struct {
+  __IO uint32_t ISER[8]; uint32_t r0[24];
+  __IO uint32_t ICER[8]; uint32_t r1[24];
+  __IO uint32_t ISPR[8]; uint32_t r2[24];
+  __IO uint32_t ICPR[8]; uint32_t r3[56];
+  __IO uint32_t IP[60];
+} NVIC_Type;
+extern NVIC_Type NVIC_s;
+#define NVIC (&NVIC_s)
+
+// CYCCNT moves on HostCycleStep cycles at every access through
+// DWT while TRCENA and CYCCNTENA are set, like a counter that is
+// running; with the default step of 0 the tests set it by hand
+typedef struct { __IO uint32_t CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT; } DWT_Type;
+extern DWT_Type DWT_s;
+extern uint32_t HostCycleStep;
+DWT_Type *Host_Dwt(void);
+#define DWT (Host_Dwt())
+#define DWT_CTRL_CYCCNTENA_Msk 1UL
+
+typedef struct { __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR; } CoreDebug_Type;
+extern CoreDebug_Type CoreDebug_s;
+#define CoreDebug (&CoreDebug_s)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL<<24)
+
+typedef struct {
+  __IO uint32_t CTL0, CTL1, LO0, HI0, LO1, HI1;
+  __IO uint32_t MCTL[32];
+  __IO uint32_t MEM[32];
+  __IO uint32_t IER0, IER1;
+  __I  uint32_t IFGR0, IFGR1;
+  __O  uint32_t CLRIFGR0, CLRIFGR1;
+  __I  uint32_t IV;
+} ADC14_Type;
+extern ADC14_Type ADC14_s;
+#define ADC14 (&ADC14_s)
+
+typedef struct {
+  __I  uint32_t POWER_STAT;
+  __IO uint32_t BANK0_RDCTL, BANK1_RDCTL, RDBRST_CTLSTAT, RDBRST_STARTADDR, RDBRST_LEN,
+                RDBRST_FAILADDR, RDBRST_FAILCNT, PRG_CTLSTAT, PRGBRST_CTLSTAT,
+                PRGBRST_STARTADDR, PRGBRST_DATA0_0, ERASE_CTLSTAT, ERASE_SECTADDR,
+                BANK0_INFO_WEPROT, BANK0_MAIN_WEPROT, BANK1_INFO_WEPROT, BANK1_MAIN_WEPROT,
+                BMRK_CTLSTAT, IFG, IE, CLRIFG, SETIFG;
+} FLCTL_Type;
+extern FLCTL_Type FLCTL_s;
+#define FLCTL (&FLCTL_s)
+#define FLCTL_BANK0_RDCTL_WAIT_2 0x00002000
+#define FLCTL_BANK1_RDCTL_WAIT_2 0x00002000
+
+typedef struct { __IO uint32_t CTL0, CTL1, IE, IFG, CLRIFG; } PCM_Type;
+extern PCM_Type PCM_s;
+#define PCM (&PCM_s)
+
+typedef struct {
+  __IO uint32_t KEY, CTL0, CTL1, CTL2, CTL3, CLKEN, STAT, IE, IFG, CLRIFG, SETIFG;
+} CS_Type;
+extern CS_Type CS_s;
+#define CS (&CS_s)
+
+// a bit-band alias is a word of its own on the host, see
+// Host_BitBand() in host.c; the port register does not change
+volatile uint32_t *Host_BitBand(volatile void *reg, int bit);
+#define BITBAND_PERI(x, b) (*Host_BitBand(&(x), (b)))
+
+#endif /* HOST_MSP_H_ */
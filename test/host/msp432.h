@@ -0,0 +1,3 @@
+// msp432.h
+// Host stand-in, see msp.h.
+#include "msp.h"
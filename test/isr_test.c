@@ -0,0 +1,74 @@
+// isr_test.c
+// Worst-case interrupt handler time of the whole firmware on
+// the host, before and after the blocking Look states went.
+// Before, a Look state spun in Clock_Delay1ms() inside
+// SysTick_Handler; now every state decides again on the next
+// frame and every handler returns without waiting.  SysTick
+// only interrupts every 10 ms: line control runs in the main
+// loop when a frame is in, the wheel loops on Timer A1.
+#include <stdint.h>
+#include "msp.h"
+#include "host.h"
+#include "qtr.h"
+#include "Clock.h"
+#include "Motor.h"
+#include "robot.h"
+#include "check.h"
+
+extern uint8_t State;
+extern volatile uint32_t Ticks;
+
+// line under sensors 4 and 5, then far to the left
+static const uint16_t Center[8] = {150, 160, 170, 2000, 2100, 180, 160, 150};
+static const uint16_t FarLeft[8] = {150, 160, 170, 180, 170, 160, 2000, 2100};
+static const uint16_t Dark[8] = {3000, 3000, 3000, 3000, 3000, 3000, 3000, 3000};
+
+// the Look left state before the change, as it ran in SysTick_Handler
+static void Legacy_LookLeft(void){
+  Motor_Left(3000, 3000);
+  Clock_Delay1ms(200);
+}
+
+int main(void){
+  RobotIsr_t legacy = {0};
+  uint64_t busy;
+  uint8_t before;
+
+  busy = HostDelayUs;
+  Legacy_LookLeft();
+  legacy.maxBusyUs = HostDelayUs - busy;
+  printf("before: Look left spun %lu us inside SysTick_Handler\n", (unsigned long)legacy.maxBusyUs);
+
+  Qtr_Set(Center, Dark);
+  if(Robot_Start()){
+    printf("isr_test: cannot map INFO flash, skipped\n");
+    return 0;
+  }
+  Robot_Run(2000000);                   // two seconds on the line
+  CHECK(RobotSysTick.count > 0);
+  CHECK(RobotCapture.count > 0);
+  CHECK(RobotTimer.count > 0);          // driving, the wheel loops run
+
+  // the line jumps to the left: the next frames turn, nothing waits
+  before = State;
+  Qtr_Set(FarLeft, Dark);
+  Robot_Run(25000);                     // two 10 ms sense periods
+  CHECK(State != before);
+
+  printf("after: SysTick_Handler x%lu, longest %.1f us, spun %lu us\n",
+         (unsigned long)RobotSysTick.count, RobotSysTick.maxNs/1000,
+         (unsigned long)RobotSysTick.maxBusyUs);
+  printf("after: TA2_0_IRQHandler x%lu, longest %.1f us, spun %lu us\n",
+         (unsigned long)RobotCapture.count, RobotCapture.maxNs/1000,
+         (unsigned long)RobotCapture.maxBusyUs);
+  printf("after: TA1_0_IRQHandler x%lu, longest %.1f us, spun %lu us\n",
+         (unsigned long)RobotTimer.count, RobotTimer.maxNs/1000,
+         (unsigned long)RobotTimer.maxBusyUs);
+  CHECK(legacy.maxBusyUs == 200000);
+  CHECK(RobotSysTick.count <= RobotNow/10000 + 1); // one SysTick per 10 ms, not per 1 ms
+  CHECK(RobotTimer.count <= RobotNow/1000 + 1);
+  CHECK(RobotSysTick.maxBusyUs == 0);
+  CHECK(RobotCapture.maxBusyUs == 0);
+  CHECK(RobotTimer.maxBusyUs == 0);
+  return Check_Done("isr_test");
+}
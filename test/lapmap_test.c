@@ -0,0 +1,102 @@
+// lapmap_test.c
+// Lap learning end to end on a simulated track: record lap
+// one, build the look-ahead, and check the map on later laps.
+// The track is a 400 cm loop with a 3 cm start/finish bar.
+// A right curve starts 5 cm after the bar, so the slowdown
+// for it must wrap around to the end of the previous lap.
+#include <stdint.h>
+#include "Reflectance.h"
+#include "LapMap.h"
+#include "check.h"
+
+extern int8_t LapCurve[];
+
+#define TRACK_MM   4000
+#define BAR_MM     30
+#define STEP_MM    3                    // 300 mm/s at one frame per 10 ms
+#define TICKS_PER_MM 1.6                // 16 encoder ticks per cm, one bin
+#define MIN_BASE   3333
+#define MAX_BASE   7333
+
+static uint32_t At;                     // mm driven
+static uint32_t Ticks;                  // encoder ticks driven
+static uint32_t MarkerAt;               // mm around the loop where the last lap began
+
+// line position the controller settles to on each part of the track
+static int32_t track_position(uint32_t mm){
+  mm %= TRACK_MM;
+  if(mm >= 50 && mm < 450) return 12000;        // right curve, 40 cm
+  if(mm >= 1950 && mm < 2350) return -9000;     // left curve, 40 cm
+  return 0;
+}
+
+// one frame, the start/finish bar is dark everywhere, no line position
+static void step(void){
+  uint32_t count = LapCount;
+  uint32_t ticks;
+  At += STEP_MM;
+  ticks = At*TICKS_PER_MM;
+  if(At%TRACK_MM < BAR_MM){
+    LapMap_Update(0xFF, REFLECTANCE_NOLINE, ticks - Ticks);
+  }else{
+    LapMap_Update(0x18, track_position(At), ticks - Ticks);
+  }
+  Ticks = ticks;
+  if(LapCount != count){
+    MarkerAt = At%TRACK_MM;
+  }
+  LapMap_Build();                       // the main loop
+}
+
+// drive on until the next frame at mm around the loop
+static void drive_to(uint32_t mm){
+  do{
+    step();
+  }while((At%TRACK_MM < mm) || (At%TRACK_MM >= mm + STEP_MM));
+}
+
+int main(void){
+  int i, wrong, bar;
+  int32_t limit;
+  uint32_t mm;
+  LapMap_Init();
+  At = TRACK_MM - 300;
+  drive_to(BAR_MM + 100);
+  CHECK(LapMode == LAP_RECORD);
+  drive_to(0);                          // lap one
+  drive_to(BAR_MM + 100);
+  CHECK(LapMode == LAP_RACE);
+  CHECK(LapCount == 2);
+  printf("recorded %u bins for a %u cm lap\n", LapLength, TRACK_MM/10);
+  CHECK(LapLength >= TRACK_MM/10 - 1 && LapLength <= TRACK_MM/10 + 1);
+
+  wrong = 0;                            // every bin inside one part of the track
+  bar = 0;
+  for(i=0; i<LapLength; i++){
+    mm = MarkerAt + 10*i;
+    if(track_position(mm) == track_position(mm + 9)){
+      int32_t expect = track_position(mm)/256;
+      if(LapCurve[i] < expect - 1 || LapCurve[i] > expect + 1) wrong++;
+    }
+    if((mm%TRACK_MM < BAR_MM) && (LapCurve[i] != 0)) bar++;
+  }
+  CHECK(wrong == 0);
+  CHECK(bar == 0);                      // no-line samples on the bar left out
+
+  drive_to(1000);                       // lap two, long straight
+  CHECK(LapMap_SpeedLimit(MIN_BASE, MAX_BASE) == MAX_BASE);
+  CHECK(LapMap_FeedForward() == 0);
+  drive_to(1900);                       // 5 cm before the left curve
+  limit = LapMap_SpeedLimit(MIN_BASE, MAX_BASE);
+  printf("speed limit 5 cm before the left curve %ld\n", (long)limit);
+  CHECK(limit < MAX_BASE);
+  CHECK(LapMap_FeedForward() < 0);      // steering left leads the curve
+  drive_to(200);                        // in the right curve of lap three
+  CHECK(LapMap_FeedForward() > 0);
+  CHECK(LapCount == 3);
+  drive_to(TRACK_MM - 40);              // end of lap three, the curve is 9 cm ahead
+  limit = LapMap_SpeedLimit(MIN_BASE, MAX_BASE);
+  printf("speed limit 9 cm before the bar %ld\n", (long)limit);
+  CHECK(limit < MAX_BASE);              // the look-ahead wrapped into the next lap
+  return Check_Done("lapmap_test");
+}
@@ -0,0 +1,120 @@
+// pid_test.c
+// Step response of the line PID on a kinematic model of the
+// robot, its anti-windup and derivative filter, and the time
+// per step on the host.
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "PID.h"
+#include "check.h"
+
+// gains as in FSM_Main.c
+#define PID_KP     13107
+#define PID_KI     88
+#define PID_KD     43691
+#define PID_ALPHA  49152
+#define PID_OUTMAX 5333
+#define PID_IMAX   2000
+
+#define FRAME_S    0.010                // one PID step per reflectance frame
+#define MM_PER_S   (550.0/10000)        // wheel speed per duty
+#define TRACK_MM   140.0                // wheel to wheel
+#define AHEAD_MM   70.0                 // sensor bar ahead of the axle
+#define BASE_DUTY  4000
+
+// robot steering onto a line that jumps 'step' mm to the right,
+// returns the step the error first stays within 1 mm, or -1
+static int step_response(double step, double *overshoot, int32_t *peak){
+  PID_t pid;
+  double y = step, heading = 0;         // robot left of the line, mm; pointing left, rad
+  double e;
+  int32_t u;
+  int k, settled = -1;
+  PID_Init(&pid, PID_KP, PID_KI, PID_KD, PID_ALPHA, PID_OUTMAX, PID_IMAX);
+  *overshoot = 0;
+  *peak = 0;
+  for(k=0; k<500; k++){
+    e = y + AHEAD_MM*sin(heading);      // line right of the sensor bar center
+    u = PID_Step(&pid, (int32_t)(e*1000));
+    if(u > *peak) *peak = u;
+    if(u < -*peak) *peak = -u;
+    heading -= 2*u*MM_PER_S/TRACK_MM*FRAME_S; // left wheel faster turns right
+    y += BASE_DUTY*MM_PER_S*sin(heading)*FRAME_S;
+    if(-e > *overshoot) *overshoot = -e;
+    if(fabs(e) < 1.0){
+      if(settled < 0) settled = k;
+    }else{
+      settled = -1;
+    }
+  }
+  return settled;
+}
+
+static void test_step(void){
+  double overshoot;
+  int32_t peak;
+  int settled = step_response(10.0, &overshoot, &peak);
+  printf("10 mm step: settled in %d frames, overshoot %.1f mm, peak %ld\n",
+         settled, overshoot, (long)peak);
+  CHECK(settled >= 0 && settled < 100);     // within a second
+  CHECK(overshoot < 3.0);
+  settled = step_response(-30.0, &overshoot, &peak);
+  printf("-30 mm step: settled in %d frames, peak %ld\n", settled, (long)peak);
+  CHECK(settled >= 0 && settled < 150);
+  CHECK(peak <= PID_OUTMAX);                // saturated, never beyond
+}
+
+// a robot held off the line must not wind the integral up
+static void test_windup(void){
+  PID_t pid;
+  int k;
+  PID_Init(&pid, PID_KP, PID_KI, PID_KD, PID_ALPHA, PID_OUTMAX, PID_IMAX);
+  for(k=0; k<3000; k++){
+    CHECK(PID_Step(&pid, 30000) == PID_OUTMAX); // proportional term alone saturates
+  }
+  CHECK(pid.integral == 0);                 // so nothing was integrated
+  for(k=0; k<3000; k++){
+    PID_Step(&pid, 20000);                  // 4000 proportional, integral fills the rest
+  }
+  printf("windup: integral %ld held at 20 mm\n", (long)(pid.integral >> 16));
+  CHECK((pid.integral >> 16) <= PID_OUTMAX - 4000 + 30);
+}
+
+// frame to frame noise, the filter keeps the derivative kick down
+static void test_filter(void){
+  PID_t raw, filtered;
+  int32_t a, b, worstRaw = 0, worstFiltered = 0;
+  int k;
+  PID_Init(&raw, 0, 0, PID_KD, 0, 100000, 0);
+  PID_Init(&filtered, 0, 0, PID_KD, PID_ALPHA, 100000, 0);
+  for(k=0; k<200; k++){
+    int32_t e = (k&1) ? 1000 : -1000;       // +/-1 mm of sensor noise
+    a = PID_Step(&raw, e);
+    b = PID_Step(&filtered, e);
+    if(a > worstRaw) worstRaw = a;
+    if(b > worstFiltered) worstFiltered = b;
+  }
+  printf("noise: derivative %ld unfiltered, %ld filtered\n", (long)worstRaw, (long)worstFiltered);
+  CHECK(worstFiltered*4 <= worstRaw);
+}
+
+static void bench(void){
+  PID_t pid;
+  volatile int32_t sink = 0;
+  clock_t start;
+  int k;
+  PID_Init(&pid, PID_KP, PID_KI, PID_KD, PID_ALPHA, PID_OUTMAX, PID_IMAX);
+  start = clock();
+  for(k=0; k<10000000; k++){
+    sink += PID_Step(&pid, (k&0xFFF) - 0x800);
+  }
+  printf("PID_Step %.1f ns on this host\n", (clock() - start)*1e9/CLOCKS_PER_SEC/1e7);
+}
+
+int main(void){
+  test_step();
+  test_windup();
+  test_filter();
+  bench();
+  return Check_Done("pid_test");
+}
@@ -0,0 +1,112 @@
+// position_test.c
+// The flash tables behind Reflectance_Position() and
+// Reflectance_Offset() against the weighted-average loop they
+// replaced, over every 8-bit reading, and a timing of both.
+// Reflectance_Centroid() against a plain mean of the weights.
+#include <stdint.h>
+#include <time.h>
+#include "msp.h"
+#include "Reflectance.h"
+#include "check.h"
+
+#define BENCH_ROUNDS 200000
+
+// the Lab 6 arithmetic, with the data == 0 divide guarded
+static int32_t Loop_Offset(uint8_t data){
+  const int32_t w[8] = {-33400, -23800, -14300, -4800,
+                        4800,   14300,  23800,  33400};
+  int32_t numerator = 0;
+  int32_t denominator = 0;
+  uint8_t bi;
+  uint32_t i;
+  for(i=0; i<8; i++){
+    bi = 0x01<<i;
+    numerator += (data & bi)*w[7-i];
+    denominator += (data & bi);
+  }
+  return denominator ? numerator/denominator : 0;
+}
+
+static int32_t Loop_Position(uint8_t data){
+  int32_t position = Loop_Offset(data);
+  if(data == 0)
+    return 0x6;                         // line lost, the loop divided by zero here
+  if(position == 0)
+    return 0x3;
+  if(position < -20000)
+    return 0x4;
+  if(position > 20000)
+    return 0x5;
+  if(position > -10000 && position < 10000)
+    return 0x0;
+  if(position > 10000 && position < 20000)
+    return 0x2;
+  if(position < -10000 && position > -20000)
+    return 0x1;
+  return 0x0;
+}
+
+static void test_equivalence(void){
+  int d, mismatches = 0;
+  for(d=0; d<256; d++){
+    if((Reflectance_Offset(d) != Loop_Offset(d))||(Reflectance_Position(d) != Loop_Position(d))){
+      printf("mismatch at 0x%02X: %ld/%ld, %ld/%ld\n", d,
+             (long)Reflectance_Offset(d), (long)Loop_Offset(d),
+             (long)Reflectance_Position(d), (long)Loop_Position(d));
+      mismatches++;
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(Reflectance_Offset(0x00) == 0);
+  CHECK(Reflectance_Position(0x00) == 0x6);
+  CHECK(Reflectance_Position(0x01) == 0x5);     // only the far right sensor
+  CHECK(Reflectance_Position(0x80) == 0x4);     // only the far left sensor
+}
+
+// the control error: mirror image readings give opposite positions
+static void test_centroid(void){
+  const int32_t w[8] = {33400, 23800, 14300, 4800,
+                        -4800, -14300, -23800, -33400};  // P7.0 is the robot's right
+  int d, i, n, mirror, asymmetric = 0, wrong = 0;
+  int32_t sum;
+  for(d=1; d<256; d++){
+    mirror = 0;
+    sum = 0;
+    n = 0;
+    for(i=0; i<8; i++){
+      if(d&(1<<i)){
+        mirror |= 0x80>>i;
+        sum += w[i];
+        n++;
+      }
+    }
+    if(Reflectance_Centroid(d) != -Reflectance_Centroid(mirror)) asymmetric++;
+    if(Reflectance_Centroid(d) != sum/n) wrong++;
+  }
+  CHECK(asymmetric == 0);
+  CHECK(wrong == 0);
+  CHECK(Reflectance_Centroid(0x18) == 0);
+  CHECK(Reflectance_Offset(0x18) == -1600);     // why the weighted one is not the error
+  CHECK(Reflectance_Centroid(0x00) == REFLECTANCE_NOLINE);
+}
+
+// ns per call over all nonzero readings
+static double bench(int32_t (*f)(uint8_t)){
+  volatile int32_t sink = 0;
+  clock_t start = clock();
+  int k, d;
+  for(k=0; k<BENCH_ROUNDS; k++){
+    for(d=1; d<256; d++){
+      sink += f(d);
+    }
+  }
+  return (clock() - start)*1e9/CLOCKS_PER_SEC/(255.0*BENCH_ROUNDS);
+}
+
+int main(void){
+  test_equivalence();
+  test_centroid();
+  printf("loop %.2f ns/call, table %.2f ns/call\n",
+         bench(Loop_Position), bench(Reflectance_Position));
+  return Check_Done("position_test");
+}
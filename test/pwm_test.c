@@ -0,0 +1,121 @@
+// pwm_test.c
+// Register model of Timer A0: the period and divider that
+// PWM_Config() picks for a frequency, the compare values of
+// normalized duties, and the CCR0 ramp that commits staged
+// duties and direction bits.
+#include <stdint.h>
+#include "msp.h"
+#include "PWM.h"
+#include "check.h"
+
+void TA0_0_IRQHandler(void);
+
+// frequency the timer actually runs at
+static double actual_hz(void){
+  uint32_t divider = (1<<((TIMER_A0->CTL>>6)&3))*(TIMER_A0->EX0+1);
+  return PWM_CLOCK/(2.0*divider*TIMER_A0->CCR[0]);
+}
+
+static void test_config(void){
+  // 20 kHz: divider 1, 300 counts
+  CHECK(PWM_Config(20000, 256) == 0);
+  CHECK(TIMER_A0->CCR[0] == 300);
+  CHECK(TIMER_A0->EX0 == 0);
+  CHECK(TIMER_A0->CTL == 0x0230);        // SMCLK, ID /1, up-down
+  CHECK(PWM_Period() == 300);
+  CHECK(TIMER_A0->CCR[3] == 0 && TIMER_A0->CCR[4] == 0);
+  printf("20000 Hz: period %u, %.1f Hz\n", TIMER_A0->CCR[0], actual_hz());
+
+  // 100 Hz still fits the 16-bit period at divider 1
+  CHECK(PWM_Config(100, 256) == 0);
+  CHECK(TIMER_A0->CCR[0] == 60000);
+  CHECK(TIMER_A0->CTL == 0x0230 && TIMER_A0->EX0 == 0);
+  printf("100 Hz: period %u, %.1f Hz\n", TIMER_A0->CCR[0], actual_hz());
+
+  // 10 Hz needs divider 10, ID /2 and EX0 /5
+  CHECK(PWM_Config(10, 256) == 0);
+  CHECK(TIMER_A0->CCR[0] == 60000);
+  CHECK(TIMER_A0->CTL == 0x0270);
+  CHECK(TIMER_A0->EX0 == 4);
+  printf("10 Hz: period %u, %.1f Hz\n", TIMER_A0->CCR[0], actual_hz());
+
+  CHECK(PWM_Config(50000, 256) == 1);    // 120 counts, too coarse
+  CHECK(PWM_Config(50000, 100) == 0);
+  CHECK(TIMER_A0->CCR[0] == 120);
+  CHECK(PWM_Config(1, 256) == 1);        // past divider 64
+  CHECK(PWM_Config(0, 256) == 1);
+}
+
+static void test_counts(void){
+  PWM_Config(20000, 256);
+  CHECK(PWM_Counts(0) == 0);
+  CHECK(PWM_Counts(5000) == 150);
+  CHECK(PWM_Counts(9999) == 299);        // never reaches the period
+  PWM_Config(100, 256);
+  CHECK(PWM_Counts(2500) == 15000);
+  CHECK(PWM_Counts(9999) == 59994);
+  PWM_Duty1(5000);
+  CHECK(TIMER_A0->CCR[3] == 30000);
+  PWM_Duty2(PWM_SCALE);                  // ignored
+  CHECK(TIMER_A0->CCR[4] == 0);
+}
+
+// run the CCR0 interrupt while it is armed, returns the periods
+static int ramp(uint32_t *phase2, int *runt){
+  int periods = 0;
+  uint32_t pin = *phase2;
+  while((TIMER_A0->CCTL[0]&0x0010) && periods < 100000){
+    TA0_0_IRQHandler();
+    if(*phase2 != pin && TIMER_A0->CCR[4] != 0) (*runt)++; // direction changed under a pulse
+    pin = *phase2;
+    periods++;
+  }
+  return periods;
+}
+
+static void test_stage(void){
+  uint32_t dir1 = 0, dir2 = 0;           // stand-ins for the P5 bit-band words
+  uint32_t commits, reversals;
+  int periods, runt = 0;
+
+  PWM_Config(20000, 256);
+  PWM_Slew(0, 0, 0);
+  PWM_Phase(&dir1, &dir2, 2);
+  commits = PwmCommits;
+  reversals = PwmReversals;
+
+  // right forward at 50%, left reverse at 25%: the left output holds
+  // 0 for the two dead periods, flips its pin, then takes its duty
+  CHECK(PWM_Stage(5000, 2500, 0, 1) == 0);
+  CHECK(TIMER_A0->CCTL[0]&0x0010);       // armed for the top of the period
+  CHECK(TIMER_A0->CCR[3] == 0);          // nothing changes before it
+  periods = ramp(&dir2, &runt);
+  printf("reversal committed in %d periods\n", periods);
+  CHECK(periods == 4);
+  CHECK(TIMER_A0->CCR[3] == 150);
+  CHECK(TIMER_A0->CCR[4] == 75);
+  CHECK(dir1 == 0 && dir2 == 1);
+  CHECK(PwmCommits == commits + 1);
+  CHECK(PwmReversals == reversals + 1);
+  CHECK(runt == 0);
+
+  // 10% per ms from 0 to 50% takes 5 ms, 100 periods at 20 kHz
+  PWM_Halt();
+  CHECK(TIMER_A0->CCR[3] == 0 && TIMER_A0->CCR[4] == 0);
+  PWM_Slew(1000, 0, 0);
+  PWM_Stage(5000, 0, 0, 1);
+  periods = ramp(&dir2, &runt);
+  printf("0 to 50%% at 10%%/ms in %d periods\n", periods);
+  CHECK(periods == 100);
+  CHECK(TIMER_A0->CCR[3] == 150);
+
+  CHECK(PWM_Stage(PWM_SCALE, 0, 0, 0) == 1);
+  CHECK(PwmDropped == 1);
+}
+
+int main(void){
+  test_config();
+  test_counts();
+  test_stage();
+  return Check_Done("pwm_test");
+}
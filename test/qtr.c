@@ -0,0 +1,72 @@
+// qtr.c
+// QTRX reflectance array model, see qtr.h.
+#include <stdint.h>
+#include "msp.h"
+#include "qtr.h"
+
+void TA2_0_IRQHandler(void);
+
+uint32_t QtrNow;
+static uint16_t Lit[8], Dark[8];
+static uint32_t ReleasedAt;             // when P7 last went to input
+static uint8_t Emitting;                // banks lit at the release
+
+// channels still above the input threshold
+static uint8_t Qtr_In(void){
+  uint32_t t = QtrNow - ReleasedAt;
+  uint8_t in = 0;
+  uint16_t decay;
+  int i;
+  if(P7->DIR == 0xFF){
+    return P7->OUT;                     // still driven
+  }
+  for(i=0; i<8; i++){
+    decay = (Emitting&(1<<(i&1))) ? Lit[i] : Dark[i];
+    if(t < decay){
+      in |= 1<<i;
+    }
+  }
+  return in;
+}
+
+void Qtr_Set(const uint16_t lit[8], const uint16_t dark[8]){
+  int i;
+  for(i=0; i<8; i++){
+    Lit[i] = lit[i];
+    Dark[i] = dark[i];
+  }
+  QtrNow = 0;
+  ReleasedAt = 0;
+}
+
+uint32_t Qtr_Armed(void){
+  if(((TIMER_A2->CTL&0x0030) == 0)||((TIMER_A2->CCTL[0]&0x0010) == 0)){
+    return 0;                           // stopped or not armed
+  }
+  return (TIMER_A2->CCR[0] + 1)/12;     // SMCLK 12 MHz, up mode
+}
+
+int Qtr_Fire(void){
+  uint8_t driven = (P7->DIR == 0xFF);
+  uint32_t armed = Qtr_Armed();
+  if(armed == 0){
+    return 0;
+  }
+  QtrNow += armed;
+  P7->IN = Qtr_In();
+  TIMER_A2->CCTL[0] |= 0x0001;          // CCIFG
+  TA2_0_IRQHandler();
+  if(driven && (P7->DIR == 0x00)){
+    ReleasedAt = QtrNow;                // bit 0 odd bank, bit 1 even bank
+    Emitting = ((P9->OUT&0x04) ? 1 : 0)|((P5->OUT&0x08) ? 2 : 0);
+  }
+  return 1;
+}
+
+int Qtr_Run(int limit){
+  int n = 0;
+  while((n < limit) && Qtr_Fire()){
+    n++;
+  }
+  return n;
+}
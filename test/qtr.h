@@ -0,0 +1,41 @@
+// qtr.h
+// Model of the QTRX reflectance array on P7 for the host
+// tests.  Each channel's capacitor decays below the input
+// threshold after a set time, which depends on whether its
+// emitter bank (P9.2 odd sensors, P5.3 even sensors) is lit.
+// Qtr_Fire() stands in for the Timer A2 interrupt: it moves
+// time on by the armed interval and drives P7->IN from the
+// model before calling TA2_0_IRQHandler().
+
+#ifndef QTR_H_
+#define QTR_H_
+#include <stdint.h>
+
+extern uint32_t QtrNow;                 // usec since Qtr_Set()
+
+// ------------Qtr_Set------------
+// Set the decay time of every channel and restart the clock.
+// Input: lit   usec to decay with the channel's emitters on
+//        dark  usec to decay with them off
+// Output: none
+void Qtr_Set(const uint16_t lit[8], const uint16_t dark[8]);
+
+// ------------Qtr_Armed------------
+// Time from the last Timer A2 event to the next interrupt.
+// Input: none
+// Output: usec, 0 if the timer is stopped or not armed
+uint32_t Qtr_Armed(void);
+
+// ------------Qtr_Fire------------
+// Deliver one Timer A2 interrupt, if the timer is armed.
+// Input: none
+// Output: 1 if an interrupt was delivered, 0 if the timer is stopped
+int Qtr_Fire(void);
+
+// ------------Qtr_Run------------
+// Deliver interrupts until the capture engine stops.
+// Input: limit  most interrupts to deliver
+// Output: number delivered
+int Qtr_Run(int limit);
+
+#endif /* QTR_H_ */
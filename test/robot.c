@@ -0,0 +1,144 @@
+// robot.c
+#define _POSIX_C_SOURCE 199309L
+// Firmware on the host, see robot.h.
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <time.h>
+#include "msp.h"
+#include "CortexM.h"
+#include "host.h"
+#include "qtr.h"
+#include "Calibration.h"
+#include "Timebase.h"
+#include "robot.h"
+
+int Firmware_Main(void);
+void SysTick_Handler(void);
+void TA1_0_IRQHandler(void);
+void TA1_N_IRQHandler(void);
+void background(void);
+
+RobotIsr_t RobotSysTick;
+RobotIsr_t RobotCapture;
+RobotIsr_t RobotTimer;
+uint32_t RobotNow;
+
+static jmp_buf Started;
+static uint32_t SysTickDue;             // usec of the next SysTick interrupt
+
+static double Robot_Ns(void){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec*1e9 + t.tv_nsec;
+}
+
+// run one handler and keep its worst case
+static void Robot_Isr(RobotIsr_t *isr, void (*handler)(void)){
+  uint64_t busy = HostDelayUs;
+  double start = Robot_Ns();
+  double ns;
+  handler();
+  ns = Robot_Ns() - start;
+  busy = HostDelayUs - busy;
+  isr->count++;
+  if(ns > isr->maxNs) isr->maxNs = ns;
+  if(busy > isr->maxBusyUs) isr->maxBusyUs = busy;
+}
+
+// the firmware went idle for the first time, initialization is over
+static void Robot_Started(void){
+  longjmp(Started, 1);
+}
+
+static void Robot_Nothing(void){
+}
+
+// Timer A2 through the QTRX model, which drives P7 first
+static void Robot_Capture(void){
+  Qtr_Fire();
+}
+
+// usec of the next TA1 CCR0 interrupt; TA1 counts RobotNow at 1 MHz
+static uint32_t Robot_TimerDue(void){
+  if((TIMER_A1->CCTL[0]&0x0010) == 0){
+    return 0xFFFFFFFF;
+  }
+  if(TIMER_A1->CCTL[0]&0x0001){         // CCIFG already set
+    return RobotNow;
+  }
+  return RobotNow + (uint16_t)(TIMER_A1->CCR[0] - (uint16_t)RobotNow);
+}
+
+int Robot_Start(void){
+  CalProfile_t *stored = Host_InfoFlash();
+  const uint32_t *word;
+  uint32_t i;
+  if(stored == 0){
+    return 1;
+  }
+  stored = (CalProfile_t *)((uint8_t *)stored + 0x800);     // INFOFLASH_RECORD
+  *stored = CalProfile;                 // defaults, as if calibrated by hand
+  stored->key = CAL_KEY;
+  stored->checksum = 0;
+  word = (const uint32_t *)stored;
+  for(i=0; i<(sizeof(CalProfile_t)/4)-1; i++){
+    stored->checksum += word[i];
+  }
+  P1->IN = 0x12;                        // both buttons up
+  memset(&RobotSysTick, 0, sizeof(RobotSysTick));
+  memset(&RobotCapture, 0, sizeof(RobotCapture));
+  memset(&RobotTimer, 0, sizeof(RobotTimer));
+  RobotNow = 0;
+  HostIdle = Robot_Started;
+  Timebase_Init();                      // the real Clock_Init48MHz() does this
+  if(setjmp(Started) == 0){
+    Firmware_Main();                    // never returns
+  }
+  HostIdle = Robot_Nothing;
+  SysTickDue = (SysTick->LOAD + 1)/48;  // 48 MHz bus clock
+  return 0;
+}
+
+void Robot_Run(uint32_t us){
+  uint32_t end = RobotNow + us;
+  uint32_t armed, captureDue, timerDue, wrapDue;
+  while(1){
+    armed = Qtr_Armed();
+    captureDue = armed ? QtrNow + armed : 0xFFFFFFFF;
+    if(captureDue < RobotNow){          // Qtr_Set() restarted the model clock, time only moves on
+      captureDue = RobotNow;
+    }
+    timerDue = Robot_TimerDue();
+    wrapDue = (RobotNow|0xFFFF) + 1;    // TA1 overflow
+    if((wrapDue <= captureDue) && (wrapDue <= timerDue) && (wrapDue <= SysTickDue) && (wrapDue <= end)){
+      RobotNow = wrapDue;
+      TIMER_A1->R = 0;
+      TIMER_A1->CTL |= 0x0001;          // TAIFG
+      TA1_N_IRQHandler();
+      continue;                         // not a wakeup for the main loop
+    }else if((timerDue <= captureDue) && (timerDue <= SysTickDue) && (timerDue <= end)){
+      RobotNow = timerDue;
+      TIMER_A1->R = (uint16_t)RobotNow;
+      Robot_Isr(&RobotTimer, TA1_0_IRQHandler);
+    }else if((captureDue <= SysTickDue) && (captureDue <= end)){
+      RobotNow = captureDue;
+      TIMER_A1->R = (uint16_t)RobotNow;
+      Robot_Isr(&RobotCapture, Robot_Capture);
+    }else if(SysTickDue <= end){
+      RobotNow = SysTickDue;
+      TIMER_A1->R = (uint16_t)RobotNow;
+      armed = Qtr_Armed();
+      Robot_Isr(&RobotSysTick, SysTick_Handler);
+      if((armed == 0) && Qtr_Armed()){
+        QtrNow = RobotNow;              // a capture was started, time it from here
+      }
+      SysTickDue = RobotNow + (SysTick->LOAD + 1)/48;
+    }else{
+      RobotNow = end;
+      break;
+    }
+    TIMER_A1->R = (uint16_t)RobotNow;
+    background();                       // the main loop between interrupts
+  }
+}
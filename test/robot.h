@@ -0,0 +1,40 @@
+// robot.h
+// The whole firmware on the host.  FSM_Main.c is built with
+// its main() renamed Firmware_Main(), and runs its own
+// initialization until it first goes idle.  After that the
+// test moves time on with Robot_Run(), which delivers the
+// SysTick, Timer A1 and Timer A2 interrupts in time order and
+// the main loop work in between.  Timer A1 counts RobotNow.  The reflectance array is the model
+// in qtr.c; the wheels do not move.
+
+#ifndef ROBOT_H_
+#define ROBOT_H_
+#include <stdint.h>
+
+// worst case of each interrupt handler since Robot_Start()
+struct RobotIsr {
+  uint32_t count;
+  double maxNs;                         // host time of the longest run
+  uint64_t maxBusyUs;                   // most usec spent in Clock_Delay* in one run
+};
+typedef struct RobotIsr RobotIsr_t;
+
+extern RobotIsr_t RobotSysTick;
+extern RobotIsr_t RobotCapture;
+extern RobotIsr_t RobotTimer;           // TA1 CCR0, the wheel loops
+extern uint32_t RobotNow;               // usec since Robot_Start()
+
+// ------------Robot_Start------------
+// Store a calibration profile and run the firmware main()
+// up to its first idle.
+// Input: none
+// Output: 0 on success, 1 if INFO flash cannot be mapped
+int Robot_Start(void);
+
+// ------------Robot_Run------------
+// Deliver interrupts for the given time.
+// Input: us  usec to run
+// Output: none
+void Robot_Run(uint32_t us);
+
+#endif /* ROBOT_H_ */
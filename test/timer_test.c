@@ -0,0 +1,66 @@
+// timer_test.c
+// Periodic events of the Timer A1 service on the register
+// stand-ins: due times, the minimum period, and a callback
+// that overruns its period skipping the missed periods
+// instead of replaying them.
+#include <stdint.h>
+#include "msp.h"
+#include "TimerService.h"
+#include "check.h"
+
+void TA1_0_IRQHandler(void);
+
+static int Runs;
+static uint16_t Overrun;                // usec the next callback takes
+
+static void tick(void){
+  Runs++;
+  TIMER_A1->R += Overrun;               // the clock moves on while it runs
+  Overrun = 0;
+}
+
+// CCR0 interrupt at the time it is armed for
+static void fire(void){
+  TIMER_A1->R = TIMER_A1->CCR[0];
+  TA1_0_IRQHandler();
+}
+
+int main(void){
+  uint8_t h;
+
+  TimerService_Init(1);
+  TIMER_A1->R = 1000;
+  h = TimerService_Every(100, tick);
+  CHECK(h != TIMER_NONE);
+  CHECK(TIMER_A1->CCR[0] == 1100);
+  CHECK(TIMER_A1->CCTL[0] == 0x0010);
+  fire();
+  CHECK(Runs == 1);
+  CHECK(TIMER_A1->CCR[0] == 1200);      // exactly one period on
+
+  // the 1200 callback takes 350 usec: 1300 runs late once,
+  // 1400 and 1500 are skipped, and the phase is kept
+  Overrun = 350;
+  fire();
+  printf("overrun: %d runs, %lu skipped, next due %u, %lu usec late\n",
+         Runs, (unsigned long)TimerSkipped, TIMER_A1->CCR[0], (unsigned long)TimerLateMax);
+  CHECK(Runs == 3);
+  CHECK(TimerSkipped == 2);
+  CHECK(TIMER_A1->CCR[0] == 1600);
+  CHECK(TimerLateMax == 250);
+  fire();
+  CHECK(Runs == 4);
+  CHECK(TIMER_A1->CCR[0] == 1700);
+  CHECK(TimerService_Cancel(h) == 1);
+  CHECK(TIMER_A1->CCTL[0] == 0x0000);   // nothing pending
+
+  // a period shorter than the handler is raised to the minimum
+  TIMER_A1->R = 5000;
+  h = TimerService_Every(1, tick);
+  CHECK(TIMER_A1->CCR[0] == 5000 + TIMER_MIN_PERIOD);
+  fire();
+  CHECK(TIMER_A1->CCR[0] == 5000 + 2*TIMER_MIN_PERIOD);
+  TimerService_Cancel(h);
+
+  return Check_Done("timer_test");
+}